@@ -0,0 +1,407 @@
+#include "AllocationTripwire.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if SYNTH_ALLOCATION_TRIPWIRE && (JUCE_MAC || JUCE_LINUX)
+ #include <cxxabi.h>
+ #include <dlfcn.h>
+ #include <cstring>
+#elif SYNTH_ALLOCATION_TRIPWIRE && JUCE_MSVC
+ #include <intrin.h>
+ #include <crtdbg.h>
+ #include <malloc.h>
+#endif
+
+namespace AllocationTripwire {
+
+#if SYNTH_ALLOCATION_TRIPWIRE
+
+namespace {
+
+// Fixed table filled lock-free from inside operator new, so recording a call
+// site can never allocate itself
+struct CallSite {
+    std::atomic<void*> address { nullptr };
+    std::atomic<int> allocations { 0 };
+    std::atomic<int> deallocations { 0 };
+};
+
+constexpr int maxCallSites = 128;
+CallSite callSites[maxCallSites];
+std::atomic<int> numViolations { 0 };
+std::atomic<int> numUntrackedViolations { 0 };  // Table was full
+std::atomic<bool> assertOnAllocation { true };
+
+// Read from inside malloc, so it must not need malloc itself: the initial-exec
+// model keeps it in static TLS even when the plugin is loaded with dlopen
+#if JUCE_GCC || JUCE_CLANG
+__attribute__((tls_model("initial-exec")))
+#endif
+thread_local int armedDepth = 0;
+
+// Turns the tripwire off for the current thread in a scope, so the allocator
+// calls made by the hooks themselves aren't counted again
+struct ScopedDisarm {
+    ScopedDisarm() : depth(armedDepth) { armedDepth = 0; }
+    ~ScopedDisarm() { armedDepth = depth; }
+    const int depth;
+};
+
+void record(void* callerAddress, bool isAllocation) {
+    numViolations.fetch_add(1, std::memory_order_relaxed);
+
+    for (auto& site : callSites) {
+        void* existing = site.address.load(std::memory_order_acquire);
+        if (existing == nullptr) {
+            void* expected = nullptr;
+            if (site.address.compare_exchange_strong(expected, callerAddress)) {
+                existing = callerAddress;
+            } else {
+                existing = expected;
+            }
+        }
+        if (existing == callerAddress) {
+            (isAllocation ? site.allocations : site.deallocations).fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    numUntrackedViolations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void checkAllocation(void* callerAddress, bool isAllocation) {
+    if (armedDepth == 0) return;
+
+    // Disarm while reporting: the assertion machinery may allocate
+    const ScopedDisarm disarm;
+    record(callerAddress, isAllocation);
+    if (isAllocation && assertOnAllocation.load(std::memory_order_relaxed)) {
+        jassertfalse;  // Allocation on the audio thread; see AllocationTripwire::getReport()
+    }
+}
+
+// operator new/delete go through these after recording the call, with the
+// tripwire off so the hooked C functions underneath don't count it twice
+void* allocate(std::size_t size) {
+    const ScopedDisarm disarm;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* allocateAligned(std::size_t size, std::size_t alignment) {
+    const ScopedDisarm disarm;
+#if JUCE_MSVC
+    return _aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+    void* ptr = nullptr;
+    return posix_memalign(&ptr, juce::jmax(alignment, sizeof(void*)), size == 0 ? 1 : size) == 0 ? ptr : nullptr;
+#endif
+}
+
+void deallocate(void* ptr) {
+    const ScopedDisarm disarm;
+    std::free(ptr);
+}
+
+void deallocateAligned(void* ptr) {
+    const ScopedDisarm disarm;
+#if JUCE_MSVC
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+juce::String describeAddress(void* address) {
+    juce::String description = juce::String::toHexString(reinterpret_cast<juce::pointer_sized_int>(address));
+#if JUCE_MAC || JUCE_LINUX
+    Dl_info info;
+    if (dladdr(address, &info) != 0 && info.dli_sname != nullptr) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        description << " " << (status == 0 && demangled != nullptr ? demangled : info.dli_sname);
+        std::free(demangled);
+    }
+#endif
+    return description;
+}
+
+} // namespace
+
+#if JUCE_MSVC
+ #define SYNTH_CALLER_ADDRESS _ReturnAddress()
+#else
+ #define SYNTH_CALLER_ADDRESS __builtin_return_address(0)
+#endif
+
+ScopedAudioThreadGuard::ScopedAudioThreadGuard() { ++armedDepth; }
+ScopedAudioThreadGuard::~ScopedAudioThreadGuard() { --armedDepth; }
+
+void setAssertOnAllocation(bool shouldAssert) { assertOnAllocation.store(shouldAssert); }
+
+int getNumViolations() { return numViolations.load(); }
+
+juce::String getReport() {
+    juce::String report;
+    report << "Audio thread allocations/deallocations: " << getNumViolations() << juce::newLine;
+
+    for (auto& site : callSites) {
+        void* address = site.address.load();
+        if (address == nullptr) break;
+        report << "  " << site.allocations.load() << " new / " << site.deallocations.load()
+               << " delete at " << describeAddress(address) << juce::newLine;
+    }
+
+    if (const int untracked = numUntrackedViolations.load(); untracked > 0) {
+        report << "  " << untracked << " more from call sites beyond the first " << maxCallSites << juce::newLine;
+    }
+    return report;
+}
+
+void reset() {
+    for (auto& site : callSites) {
+        site.allocations.store(0);
+        site.deallocations.store(0);
+        site.address.store(nullptr);
+    }
+    numViolations.store(0);
+    numUntrackedViolations.store(0);
+}
+
+#else
+
+void setAssertOnAllocation(bool) {}
+int getNumViolations() { return 0; }
+juce::String getReport() { return "Allocation tripwire disabled (build with SYNTH_ALLOCATION_TRIPWIRE=1)"; }
+void reset() {}
+
+#endif
+
+} // namespace AllocationTripwire
+
+#if SYNTH_ALLOCATION_TRIPWIRE
+
+// Global replacements for every operator new/delete form that allocates,
+// aligned ones included
+void* operator new(std::size_t size) {
+    AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, true);
+    if (void* ptr = AllocationTripwire::allocate(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, true);
+    if (void* ptr = AllocationTripwire::allocate(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, true);
+    return AllocationTripwire::allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, true);
+    return AllocationTripwire::allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, true);
+    if (void* ptr = AllocationTripwire::allocateAligned(size, static_cast<std::size_t>(alignment))) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, true);
+    if (void* ptr = AllocationTripwire::allocateAligned(size, static_cast<std::size_t>(alignment))) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, true);
+    return AllocationTripwire::allocateAligned(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, true);
+    return AllocationTripwire::allocateAligned(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr != nullptr) AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, false);
+    AllocationTripwire::deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    if (ptr != nullptr) AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, false);
+    AllocationTripwire::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    if (ptr != nullptr) AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, false);
+    AllocationTripwire::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    if (ptr != nullptr) AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, false);
+    AllocationTripwire::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    if (ptr != nullptr) AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, false);
+    AllocationTripwire::deallocateAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    if (ptr != nullptr) AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, false);
+    AllocationTripwire::deallocateAligned(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    if (ptr != nullptr) AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, false);
+    AllocationTripwire::deallocateAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    if (ptr != nullptr) AllocationTripwire::checkAllocation(SYNTH_CALLER_ADDRESS, false);
+    AllocationTripwire::deallocateAligned(ptr);
+}
+
+#if JUCE_MAC || JUCE_LINUX
+
+// The C allocation functions, so JUCE's HeapBlock (and with it AudioBuffer,
+// MemoryBlock and friends) is caught as well. Only this binary's own calls
+// reach them, not the host's; the real functions come from dlsym(RTLD_NEXT). dlsym may itself calloc before they are known,
+// so those first few requests are served from a small static arena.
+namespace AllocationTripwire {
+namespace {
+
+using MallocFunction = void* (*)(std::size_t);
+using CallocFunction = void* (*)(std::size_t, std::size_t);
+using ReallocFunction = void* (*)(void*, std::size_t);
+using FreeFunction = void (*)(void*);
+using PosixMemalignFunction = int (*)(void**, std::size_t, std::size_t);
+
+MallocFunction realMalloc = nullptr;
+CallocFunction realCalloc = nullptr;
+ReallocFunction realRealloc = nullptr;
+PosixMemalignFunction realPosixMemalign = nullptr;
+std::atomic<FreeFunction> realFree { nullptr };  // Stored last; set means all are
+std::atomic<bool> resolving { false };
+
+alignas(16) char bootstrapArena[8192];
+std::atomic<std::size_t> bootstrapUsed { 0 };
+
+void* bootstrapAllocate(std::size_t size) {
+    const std::size_t rounded = (size + 15) & ~static_cast<std::size_t>(15);
+    const std::size_t offset = bootstrapUsed.fetch_add(rounded);
+    return offset + rounded <= sizeof(bootstrapArena) ? bootstrapArena + offset : nullptr;  // Zeroed, being static
+}
+
+bool isBootstrap(const void* ptr) {
+    return ptr >= bootstrapArena && ptr < bootstrapArena + sizeof(bootstrapArena);
+}
+
+// False while dlsym is still running, for the arena to step in
+bool resolveRealFunctions() {
+    if (realFree.load(std::memory_order_acquire) != nullptr) return true;
+    if (resolving.exchange(true)) return false;
+
+    realMalloc = reinterpret_cast<MallocFunction>(dlsym(RTLD_NEXT, "malloc"));
+    realCalloc = reinterpret_cast<CallocFunction>(dlsym(RTLD_NEXT, "calloc"));
+    realRealloc = reinterpret_cast<ReallocFunction>(dlsym(RTLD_NEXT, "realloc"));
+    realPosixMemalign = reinterpret_cast<PosixMemalignFunction>(dlsym(RTLD_NEXT, "posix_memalign"));
+    realFree.store(reinterpret_cast<FreeFunction>(dlsym(RTLD_NEXT, "free")), std::memory_order_release);
+    return true;
+}
+
+} // namespace
+} // namespace AllocationTripwire
+
+#if JUCE_LINUX
+ #define SYNTH_C_ALLOCATOR_NOEXCEPT noexcept  // glibc declares them __THROW
+#else
+ #define SYNTH_C_ALLOCATOR_NOEXCEPT
+#endif
+#define SYNTH_C_ALLOCATOR extern "C"
+
+// libc has already declared them with default visibility, so hide them at the
+// assembler level. Mach-O needs nothing: a dylib's calls bind to its own
+// definitions under the two-level namespace.
+#if JUCE_LINUX
+__asm__(".hidden malloc\n.hidden calloc\n.hidden realloc\n.hidden free\n.hidden posix_memalign");
+#endif
+
+SYNTH_C_ALLOCATOR void* malloc(std::size_t size) SYNTH_C_ALLOCATOR_NOEXCEPT {
+    using namespace AllocationTripwire;
+    if (!resolveRealFunctions()) return bootstrapAllocate(size);
+    checkAllocation(SYNTH_CALLER_ADDRESS, true);
+    return realMalloc(size);
+}
+
+SYNTH_C_ALLOCATOR void* calloc(std::size_t count, std::size_t size) SYNTH_C_ALLOCATOR_NOEXCEPT {
+    using namespace AllocationTripwire;
+    if (!resolveRealFunctions()) return bootstrapAllocate(count * size);
+    checkAllocation(SYNTH_CALLER_ADDRESS, true);
+    return realCalloc(count, size);
+}
+
+SYNTH_C_ALLOCATOR void* realloc(void* ptr, std::size_t size) SYNTH_C_ALLOCATOR_NOEXCEPT {
+    using namespace AllocationTripwire;
+    if (!resolveRealFunctions()) return bootstrapAllocate(size);
+    checkAllocation(SYNTH_CALLER_ADDRESS, true);
+
+    if (isBootstrap(ptr)) {
+        // Arena blocks don't record their size; copy what can be there
+        void* moved = realMalloc(size);
+        if (moved != nullptr) {
+            const auto available = static_cast<std::size_t>(bootstrapArena + sizeof(bootstrapArena) - static_cast<char*>(ptr));
+            std::memcpy(moved, ptr, juce::jmin(size, available));
+        }
+        return moved;
+    }
+    return realRealloc(ptr, size);
+}
+
+SYNTH_C_ALLOCATOR void free(void* ptr) SYNTH_C_ALLOCATOR_NOEXCEPT {
+    using namespace AllocationTripwire;
+    if (ptr == nullptr || isBootstrap(ptr)) return;
+    checkAllocation(SYNTH_CALLER_ADDRESS, false);
+    if (auto* function = realFree.load(std::memory_order_acquire)) function(ptr);
+}
+
+SYNTH_C_ALLOCATOR int posix_memalign(void** result, std::size_t alignment, std::size_t size) SYNTH_C_ALLOCATOR_NOEXCEPT {
+    using namespace AllocationTripwire;
+    if (!resolveRealFunctions()) {
+        *result = bootstrapAllocate(size + alignment);
+        if (*result == nullptr) return ENOMEM;
+        *result = reinterpret_cast<void*>((reinterpret_cast<std::uintptr_t>(*result) + alignment - 1) & ~(alignment - 1));
+        return 0;
+    }
+    checkAllocation(SYNTH_CALLER_ADDRESS, true);
+    return realPosixMemalign(result, alignment, size);
+}
+
+#elif JUCE_MSVC && defined(_DEBUG)
+
+// The debug CRT reports every malloc/realloc/free to one hook. The caller
+// address it gives is inside the CRT, so the report groups these under a few
+// CRT entries rather than by call site. Release CRTs have no hook.
+namespace AllocationTripwire {
+namespace {
+
+int crtAllocationHook(int allocationType, void*, std::size_t, int blockType, long, const unsigned char*, int) {
+    if (blockType != _CRT_BLOCK) {  // The CRT's own bookkeeping
+        checkAllocation(SYNTH_CALLER_ADDRESS, allocationType != _HOOK_FREE);
+    }
+    return TRUE;
+}
+
+const auto previousHook = _CrtSetAllocHook(crtAllocationHook);
+
+} // namespace
+} // namespace AllocationTripwire
+
+#endif
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Debug/benchmark aid that replaces the global operator new/delete (aligned
+// forms included) and hooks malloc, calloc, realloc, free and posix_memalign,
+// then records every allocation or deallocation made on a thread while it is
+// "armed" - i.e. inside processBlock or a voice render job. The C functions are
+// interposed on Linux and macOS and seen through the debug CRT's hook on
+// Windows. Build with SYNTH_ALLOCATION_TRIPWIRE=1 to enable; otherwise the
+// guard compiles to nothing and the allocator is left alone.
+#ifndef SYNTH_ALLOCATION_TRIPWIRE
+ #define SYNTH_ALLOCATION_TRIPWIRE 0
+#endif
+
+namespace AllocationTripwire {
+
+// Arms the tripwire for the current thread for the lifetime of the object
+struct ScopedAudioThreadGuard {
+#if SYNTH_ALLOCATION_TRIPWIRE
+    ScopedAudioThreadGuard();
+    ~ScopedAudioThreadGuard();
+#else
+    ScopedAudioThreadGuard() {}
+#endif
+    JUCE_DECLARE_NON_COPYABLE(ScopedAudioThreadGuard)
+};
+
+// When set, any allocation on an armed thread also hits jassertfalse
+void setAssertOnAllocation(bool shouldAssert);
+
+// Allocations plus deallocations seen on armed threads since the last reset()
+int getNumViolations();
+
+// One line per call site (the code that called the allocator) with its
+// count, symbolised where the platform allows. Allocates, so never call it from
+// the audio thread.
+juce::String getReport();
+
+void reset();
+
+} // namespace AllocationTripwire
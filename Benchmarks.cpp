@@ -0,0 +1,364 @@
+// Microbenchmarks for the DSP hot paths: SynthVoice rendering,
+// WavetableSynthesizer::renderNextBlock, Sampler::renderNextBlock and the full
+// NewProjectAudioProcessor::processBlock. Each benchmark sweeps one parameter
+// (polyphony, unison size, block size or sample rate) with the others at their
+// defaults and reports ns per output sample, ns per voice-sample and how many
+// voices one core could run at 1x real time.
+//
+// Rendering runs with the allocation tripwire armed, so in a build with
+// SYNTH_ALLOCATION_TRIPWIRE=1 every result also counts the allocator calls it
+// made and the call sites are reported at the end.
+//
+// Like OfflineRenderer.cpp this is a separate console target, compiled out of
+// the plugin unless SYNTH_BUILD_BENCHMARKS=1; BUILDING.md has the target.
+//
+//   Benchmarks [--json results.json] [--filter synth] [--seconds 1]
+#ifndef SYNTH_BUILD_BENCHMARKS
+ #define SYNTH_BUILD_BENCHMARKS 0
+#endif
+
+#if SYNTH_BUILD_BENCHMARKS
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "AllocationTripwire.h"
+#include "SynthVoice.h"
+#include "WavetableSynthesizer.h"
+#include "Sampler.h"
+#include <functional>
+#include <iostream>
+
+namespace {
+
+struct BenchmarkConfig {
+    int polyphony = 16;
+    int unisonSize = 1;
+    int blockSize = 512;
+    double sampleRate = 48000.0;
+};
+
+struct BenchmarkResult {
+    juce::String name;
+    BenchmarkConfig config;
+    double nsPerSample = 0.0;       // Wall time per output sample
+    double nsPerVoiceSample = 0.0;  // The same divided by the voices sounding
+    double voicesPerCore = 0.0;     // Voices one core could render at 1x real time
+    int allocations = 0;            // Allocator calls while rendering; should stay 0
+};
+
+const int polyphonySweep[] = { 1, 8, 16, 32, 64, 128 };
+const int unisonSweep[] = { 1, 2, 4, 8, 16 };
+const int blockSizeSweep[] = { 16, 64, 256, 1024, 4096 };
+const double sampleRateSweep[] = { 44100.0, 48000.0, 96000.0 };
+
+constexpr int numRuns = 5;  // The median run is reported
+
+// Renders secondsOfAudio worth of blocks through renderBlock and returns the
+// median wall time in nanoseconds
+double timeRuns(const BenchmarkConfig& config, double secondsOfAudio,
+                const std::function<void()>& setUp, const std::function<void(int)>& renderBlock) {
+    const auto totalSamples = static_cast<juce::int64>(secondsOfAudio * config.sampleRate);
+    std::vector<double> runs;
+
+    for (int run = 0; run < numRuns; ++run) {
+        setUp();
+        const auto start = juce::Time::getHighResolutionTicks();
+        {
+            // Rendering is held to the audio thread's rules; setting up isn't
+            AllocationTripwire::ScopedAudioThreadGuard allocationGuard;
+            for (juce::int64 done = 0; done < totalSamples; done += config.blockSize) {
+                renderBlock(static_cast<int>(juce::jmin(static_cast<juce::int64>(config.blockSize), totalSamples - done)));
+            }
+        }
+        runs.push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1.0e9);
+    }
+
+    std::sort(runs.begin(), runs.end());
+    return runs[runs.size() / 2];
+}
+
+BenchmarkResult makeResult(const juce::String& name, const BenchmarkConfig& config, double nanoseconds,
+                           double secondsOfAudio, int numVoices) {
+    BenchmarkResult result;
+    result.name = name;
+    result.config = config;
+    const double numSamples = secondsOfAudio * config.sampleRate;
+    result.nsPerSample = nanoseconds / numSamples;
+    result.nsPerVoiceSample = result.nsPerSample / juce::jmax(1, numVoices);
+    result.voicesPerCore = (1.0e9 / config.sampleRate) / juce::jmax(1.0e-3, result.nsPerVoiceSample);
+    return result;
+}
+
+// Notes spread over a few octaves so voices don't share pitches
+int noteForVoice(int index) {
+    return 36 + (index * 7) % 60;
+}
+
+BenchmarkResult benchmarkSynthVoice(const BenchmarkConfig& config, double seconds) {
+    std::vector<std::unique_ptr<SynthVoice>> voices;
+    auto bank = WavetableSynthesizer::getDefaultBank();
+    for (int i = 0; i < config.polyphony; ++i) {
+        auto voice = std::make_unique<SynthVoice>();
+        voice->prepareToPlay(config.sampleRate, config.blockSize);
+        voice->setWavetable(bank.get());
+        voice->setWaveform(WavetableSynthesizer::Sawtooth);
+        voice->setUnisonSize(config.unisonSize);
+        voice->setDetuneAmount(0.1f);
+        voices.push_back(std::move(voice));
+    }
+    std::vector<float> out(static_cast<size_t>(config.blockSize));
+
+    const double ns = timeRuns(config, seconds,
+        [&] {
+            for (size_t i = 0; i < voices.size(); ++i) {
+                voices[i]->startNote(noteForVoice(static_cast<int>(i)), 0.8f);
+            }
+        },
+        [&](int numSamples) {
+            std::fill(out.begin(), out.begin() + numSamples, 0.0f);
+            for (auto& voice : voices) {
+                voice->renderBlock(out.data(), numSamples);
+            }
+        });
+    return makeResult("SynthVoice::renderBlock", config, ns, seconds, config.polyphony);
+}
+
+BenchmarkResult benchmarkWavetableSynth(const BenchmarkConfig& config, double seconds) {
+    WavetableSynthesizer synth;
+    const int numVoices = juce::jmin(config.polyphony, WavetableSynthesizer::maxVoices);
+    synth.setPolyphony(numVoices);
+    synth.setWaveform(WavetableSynthesizer::Sawtooth);
+    synth.setUnisonSize(config.unisonSize);
+    synth.setDetuneAmount(0.1f);
+    synth.prepareToPlay(config.sampleRate, config.blockSize);
+    juce::AudioBuffer<float> buffer(2, config.blockSize);
+
+    const double ns = timeRuns(config, seconds,
+        [&] {
+            for (int i = 0; i < numVoices; ++i) {
+                synth.handleNoteOn(noteForVoice(i), 0.8f);
+            }
+        },
+        [&](int numSamples) {
+            buffer.clear();
+            synth.renderNextBlock(buffer, 0, numSamples);
+        });
+    return makeResult("WavetableSynthesizer::renderNextBlock", config, ns, seconds, numVoices);
+}
+
+// Ten seconds of stereo sine, written once so the sampler has something to play
+juce::File getTestSample() {
+    static const juce::File file = [] {
+        auto f = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("SynthBenchmarkSample.wav");
+        const double rate = 48000.0;
+        juce::AudioBuffer<float> data(2, static_cast<int>(10.0 * rate));
+        for (int i = 0; i < data.getNumSamples(); ++i) {
+            const float value = 0.5f * std::sin(juce::MathConstants<float>::twoPi * 220.0f * static_cast<float>(i / rate));
+            data.setSample(0, i, value);
+            data.setSample(1, i, value);
+        }
+        f.deleteFile();
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(new juce::FileOutputStream(f), rate, 2, 16, {}, 0));
+        writer->writeFromAudioSampleBuffer(data, 0, data.getNumSamples());
+        return f;
+    }();
+    return file;
+}
+
+// Loading is asynchronous; wait until a note actually sounds
+bool waitForSample(Sampler& sampler, int blockSize) {
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    for (int attempt = 0; attempt < 500; ++attempt) {
+        sampler.handleNoteOn(60, 1.0f);
+        buffer.clear();
+        sampler.renderNextBlock(buffer, 0, blockSize);
+        sampler.handleNoteOff(60, 1.0f);
+        if (buffer.getMagnitude(0, blockSize) > 0.0f) return true;
+        juce::Thread::sleep(10);
+    }
+    return false;
+}
+
+BenchmarkResult benchmarkSampler(const BenchmarkConfig& config, double seconds) {
+    Sampler sampler;
+    sampler.prepareToPlay(config.sampleRate, config.blockSize);
+    sampler.loadSample(getTestSample().getFullPathName());
+    if (!waitForSample(sampler, config.blockSize)) {
+        std::cerr << "Sampler benchmark: sample never loaded\n";
+    }
+
+    const int numVoices = juce::jmin(config.polyphony, Sampler::numVoices);
+    juce::AudioBuffer<float> buffer(2, config.blockSize);
+
+    const double ns = timeRuns(config, seconds,
+        [&] {
+            for (int i = 0; i < numVoices; ++i) {
+                sampler.handleNoteOn(noteForVoice(i), 0.8f);
+            }
+        },
+        [&](int numSamples) {
+            buffer.clear();
+            sampler.renderNextBlock(buffer, 0, numSamples);
+        });
+
+    for (int i = 0; i < numVoices; ++i) {
+        sampler.handleNoteOff(noteForVoice(i), 0.0f);
+    }
+    return makeResult("Sampler::renderNextBlock", config, ns, seconds, numVoices);
+}
+
+BenchmarkResult benchmarkProcessor(const BenchmarkConfig& config, double seconds) {
+    NewProjectAudioProcessor processor;
+    processor.setPolyphony(juce::jmin(config.polyphony, WavetableSynthesizer::maxVoices));
+    processor.setUnisonSize(config.unisonSize);
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(config.sampleRate, config.blockSize);
+    processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+    juce::AudioBuffer<float> buffer(2, config.blockSize);
+    juce::MidiBuffer midi;
+    bool notesPending = false;
+    const int numVoices = juce::jmin(config.polyphony, WavetableSynthesizer::maxVoices);
+
+    const double ns = timeRuns(config, seconds,
+        [&] { notesPending = true; },
+        [&](int numSamples) {
+            midi.clear();
+            if (notesPending) {
+                for (int i = 0; i < numVoices; ++i) {
+                    midi.addEvent(juce::MidiMessage::noteOn(1, noteForVoice(i), 0.8f), 0);
+                }
+                notesPending = false;
+            }
+            buffer.setSize(2, numSamples, false, false, true);
+            buffer.clear();
+            processor.processBlock(buffer, midi);
+        });
+
+    processor.releaseResources();
+    return makeResult("NewProjectAudioProcessor::processBlock", config, ns, seconds, numVoices);
+}
+
+using BenchmarkFunction = BenchmarkResult (*)(const BenchmarkConfig&, double);
+
+// maxPolyphony is the engine's voice pool size; sweep points above it would
+// only repeat the capped result, so they're skipped
+void runSweeps(const juce::String& name, BenchmarkFunction benchmark, int maxPolyphony, double seconds,
+               std::vector<BenchmarkResult>& results) {
+    auto run = [&](const BenchmarkConfig& config) {
+        const int allocationsBefore = AllocationTripwire::getNumViolations();
+        auto result = benchmark(config, seconds);
+        result.allocations = AllocationTripwire::getNumViolations() - allocationsBefore;
+
+        std::cout << result.name << "  voices " << result.config.polyphony << "  unison " << result.config.unisonSize
+                  << "  block " << result.config.blockSize << "  rate " << result.config.sampleRate
+                  << "  ->  " << result.nsPerSample << " ns/sample, " << result.nsPerVoiceSample
+                  << " ns/voice-sample, " << static_cast<int>(result.voicesPerCore) << " voices/core, "
+                  << result.allocations << " allocations\n";
+        results.push_back(result);
+    };
+
+    std::cout << "== " << name << "\n";
+    for (int polyphony : polyphonySweep) {
+        if (polyphony > maxPolyphony) break;
+        BenchmarkConfig config;
+        config.polyphony = polyphony;
+        run(config);
+    }
+    for (int unison : unisonSweep) {
+        BenchmarkConfig config;
+        config.unisonSize = unison;
+        run(config);
+    }
+    for (int blockSize : blockSizeSweep) {
+        BenchmarkConfig config;
+        config.blockSize = blockSize;
+        run(config);
+    }
+    for (double sampleRate : sampleRateSweep) {
+        BenchmarkConfig config;
+        config.sampleRate = sampleRate;
+        run(config);
+    }
+}
+
+juce::var toJson(const std::vector<BenchmarkResult>& results) {
+    juce::Array<juce::var> list;
+    for (const auto& result : results) {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("benchmark", result.name);
+        entry->setProperty("polyphony", result.config.polyphony);
+        entry->setProperty("unisonSize", result.config.unisonSize);
+        entry->setProperty("blockSize", result.config.blockSize);
+        entry->setProperty("sampleRate", result.config.sampleRate);
+        entry->setProperty("nsPerSample", result.nsPerSample);
+        entry->setProperty("nsPerVoiceSample", result.nsPerVoiceSample);
+        entry->setProperty("voicesPerCore", result.voicesPerCore);
+        entry->setProperty("allocations", result.allocations);
+        list.add(juce::var(entry));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("numCores", juce::SystemStats::getNumPhysicalCpus());
+    root->setProperty("allocationTripwire", SYNTH_ALLOCATION_TRIPWIRE != 0);
+    root->setProperty("allocationReport", AllocationTripwire::getReport());
+    root->setProperty("results", list);
+    return juce::var(root);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    AllocationTripwire::reset();  // Start-up allocations aren't the engine's
+
+    juce::File jsonFile;
+    juce::String filter;
+    double seconds = 1.0;  // Audio rendered per run
+
+    for (int i = 1; i < argc; ++i) {
+        const juce::String arg(argv[i]);
+        const juce::String value = i + 1 < argc ? juce::String(argv[i + 1]) : juce::String();
+        if (arg == "--json")         { jsonFile = juce::File::getCurrentWorkingDirectory().getChildFile(value); ++i; }
+        else if (arg == "--filter")  { filter = value; ++i; }
+        else if (arg == "--seconds") { seconds = juce::jmax(0.01, value.getDoubleValue()); ++i; }
+        else {
+            std::cerr << "Usage: Benchmarks [--json <file>] [--filter <name>] [--seconds <audio per run>]\n";
+            return 1;
+        }
+    }
+
+    struct Benchmark {
+        const char* name;
+        BenchmarkFunction function;
+        int maxPolyphony;
+    };
+    const Benchmark benchmarks[] = {
+        { "SynthVoice", benchmarkSynthVoice, std::numeric_limits<int>::max() },  // Voices are made to order
+        { "WavetableSynthesizer", benchmarkWavetableSynth, WavetableSynthesizer::maxVoices },
+        { "Sampler", benchmarkSampler, Sampler::numVoices },
+        { "Processor", benchmarkProcessor, WavetableSynthesizer::maxVoices },
+    };
+
+    std::vector<BenchmarkResult> results;
+    for (const auto& benchmark : benchmarks) {
+        if (filter.isEmpty() || juce::String(benchmark.name).containsIgnoreCase(filter)) {
+            runSweeps(benchmark.name, benchmark.function, benchmark.maxPolyphony, seconds, results);
+        }
+    }
+
+    std::cout << "== Allocation tripwire\n" << AllocationTripwire::getReport() << "\n";
+
+    if (jsonFile != juce::File()) {
+        if (!jsonFile.replaceWithText(juce::JSON::toString(toJson(results)))) {
+            std::cerr << "Couldn't write " << jsonFile.getFullPathName() << "\n";
+            return 1;
+        }
+        std::cout << "Wrote " << jsonFile.getFullPathName() << "\n";
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,136 @@
+#include "BlockEnvelope.h"
+
+namespace {
+    // 1, 2, 3, ... for building linear ramps with one multiply-add
+    struct RampTable {
+        float values[64];
+        RampTable() {
+            for (int i = 0; i < 64; ++i) values[i] = static_cast<float>(i + 1);
+        }
+    };
+    const RampTable rampTable;
+}
+
+void BlockEnvelope::setSampleRate(double newSampleRate) {
+    sampleRate = newSampleRate;
+}
+
+void BlockEnvelope::setParameters(const juce::ADSR::Parameters& newParameters) {
+    parameters = newParameters;
+    parameters.sustain = juce::jlimit(0.0f, 1.0f, parameters.sustain);
+    if (stage == Sustain) {
+        level = parameters.sustain;
+    }
+}
+
+int BlockEnvelope::secondsToSamples(float seconds, double rate) {
+    return juce::jmax(1, juce::roundToInt(seconds * rate));
+}
+
+float BlockEnvelope::getExponentialCoefficient(int numSamples) {
+    // Distance to the target shrinks from (1 + r) to r of the travelled distance
+    return static_cast<float>(std::exp(-std::log((1.0 + overshootRatio) / overshootRatio) / numSamples));
+}
+
+void BlockEnvelope::noteOn() {
+    enterStage(Attack);
+}
+
+void BlockEnvelope::noteOff() {
+    if (stage != Idle) {
+        enterStage(Release);
+    }
+}
+
+void BlockEnvelope::reset() {
+    stage = Idle;
+    level = 0.0f;
+}
+
+void BlockEnvelope::enterStage(Stage newStage) {
+    stage = newStage;
+    switch (stage) {
+        case Attack:
+            samplesLeftInStage = secondsToSamples(parameters.attack, sampleRate);
+            increment = (1.0f - level) / static_cast<float>(samplesLeftInStage);
+            break;
+        case Decay:
+            samplesLeftInStage = secondsToSamples(parameters.decay, sampleRate);
+            target = parameters.sustain - overshootRatio * (level - parameters.sustain);
+            coefficient = getExponentialCoefficient(samplesLeftInStage);
+            break;
+        case Release:
+            samplesLeftInStage = secondsToSamples(parameters.release, sampleRate);
+            target = -overshootRatio * level;
+            coefficient = getExponentialCoefficient(samplesLeftInStage);
+            break;
+        case Sustain:
+            level = parameters.sustain;
+            break;
+        case Idle:
+            level = 0.0f;
+            break;
+    }
+}
+
+void BlockEnvelope::render(float* out, int numSamples) {
+    while (numSamples > 0) {
+        const int done = renderRun(out, numSamples);
+        out += done;
+        numSamples -= done;
+    }
+}
+
+// Renders up to the end of the current stage or maxRunLength samples,
+// whichever comes first, and returns how many were written
+int BlockEnvelope::renderRun(float* out, int numSamples) {
+    if (stage == Idle || stage == Sustain) {
+        juce::FloatVectorOperations::fill(out, level, numSamples);
+        return numSamples;
+    }
+
+    static_assert(sizeof(RampTable::values) / sizeof(float) >= maxRunLength, "Ramp table too short");
+    const int runLength = juce::jmin(numSamples, samplesLeftInStage, maxRunLength);
+
+    if (stage == Attack) {
+        // level + increment * (i + 1)
+        juce::FloatVectorOperations::copyWithMultiply(out, rampTable.values, increment, runLength);
+        juce::FloatVectorOperations::add(out, level, runLength);
+    } else {
+        // target + (level - target) * coefficient^(i + 1); the powers are built by
+        // doubling, so the run costs log2(runLength) vector multiplies
+        float powers[maxRunLength];
+        powers[0] = coefficient;
+        float step = coefficient;
+        for (int filled = 1; filled < runLength; filled *= 2) {
+            juce::FloatVectorOperations::copyWithMultiply(powers + filled, powers, step,
+                                                          juce::jmin(filled, runLength - filled));
+            step *= step;
+        }
+        juce::FloatVectorOperations::copyWithMultiply(out, powers, level - target, runLength);
+        juce::FloatVectorOperations::add(out, target, runLength);
+    }
+
+    level = out[runLength - 1];
+    samplesLeftInStage -= runLength;
+    if (samplesLeftInStage == 0) {
+        // Land exactly on the end level; the overshoot never shows
+        switch (stage) {
+            case Attack:
+                level = out[runLength - 1] = 1.0f;
+                enterStage(Decay);
+                break;
+            case Decay:
+                out[runLength - 1] = parameters.sustain;
+                enterStage(Sustain);
+                break;
+            case Release:
+                out[runLength - 1] = 0.0f;
+                enterStage(Idle);
+                break;
+            default:
+                break;
+        }
+    }
+    return runLength;
+}
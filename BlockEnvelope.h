@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// ADSR envelope generated a segment at a time instead of a sample at a time.
+// Each stage is closed-form from where it started: attack is a linear ramp,
+// decay and release are exponentials aimed just past their end level so they
+// arrive in exactly the set time. A run of samples is then a handful of
+// FloatVectorOperations calls rather than a branchy per-sample state machine.
+class BlockEnvelope {
+public:
+    BlockEnvelope() = default;
+
+    void setSampleRate(double newSampleRate);
+    // Takes effect at the next stage boundary, except sustain, which a held note
+    // follows straight away
+    void setParameters(const juce::ADSR::Parameters& newParameters);
+
+    // Attack starts from the current level, so a retriggered voice doesn't click
+    void noteOn();
+    void noteOff();
+    void reset();
+
+    bool isActive() const { return stage != Idle; }
+    float getCurrentLevel() const { return level; }
+
+    // Writes numSamples of envelope gain to out. Once the release has finished
+    // the rest is zero and isActive() turns false.
+    void render(float* out, int numSamples);
+
+private:
+    enum Stage { Idle, Attack, Decay, Sustain, Release };
+
+    void enterStage(Stage newStage);
+    int renderRun(float* out, int numSamples);
+    // Coefficient for an exponential that covers its whole distance in numSamples
+    static float getExponentialCoefficient(int numSamples);
+    static int secondsToSamples(float seconds, double sampleRate);
+
+    static constexpr int maxRunLength = 64;
+    // How far past its end level an exponential stage aims, relative to the
+    // distance it travels; smaller is more curved
+    static constexpr float overshootRatio = 0.001f;
+
+    juce::ADSR::Parameters parameters { 0.5f, 0.1f, 0.8f, 0.5f };
+    double sampleRate = 48000.0;
+
+    Stage stage = Idle;
+    float level = 0.0f;
+    int samplesLeftInStage = 0;
+    float increment = 0.0f;    // Attack: level change per sample
+    float target = 0.0f;       // Decay/release: the level aimed at
+    float coefficient = 0.0f;  // Decay/release: per-sample decay towards target
+};
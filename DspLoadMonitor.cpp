@@ -0,0 +1,108 @@
+#include "DspLoadMonitor.h"
+
+DspLoadMonitor::DspLoadMonitor()
+    : microsPerTick(1.0e6 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond())) {}
+
+void DspLoadMonitor::prepare(double newSampleRate) {
+    sampleRate.store(newSampleRate);
+    overruns.store(0);
+}
+
+void DspLoadMonitor::beginBlock(int numSamples) {
+    current = {};
+    current.numSamples = numSamples;
+    blockStartTicks = juce::Time::getHighResolutionTicks();
+}
+
+void DspLoadMonitor::endBlock(int activeVoices) {
+    current.totalTicks = juce::Time::getHighResolutionTicks() - blockStartTicks;
+    current.activeVoices = activeVoices;
+
+    const double budgetMicros = 1.0e6 * current.numSamples / sampleRate.load(std::memory_order_relaxed);
+    if (current.totalTicks * microsPerTick > budgetMicros) {
+        overruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // If the reader has fallen behind, this block just goes unrecorded
+    if (fifo.getFreeSpace() > 0) {
+        const auto scope = fifo.write(1);
+        records[static_cast<size_t>(scope.startIndex1)] = current;
+    }
+}
+
+void DspLoadMonitor::update() {
+    const double rate = sampleRate.load(std::memory_order_relaxed);
+
+    const auto scope = fifo.read(fifo.getNumReady());
+    scope.forEach([&](int index) {
+        const auto& record = records[static_cast<size_t>(index)];
+        const double blockMicros = record.totalTicks * microsPerTick;
+        const double load = record.numSamples > 0 ? blockMicros / (1.0e6 * record.numSamples / rate) : 0.0;
+
+        pendingTotalMicros += blockMicros;
+        pendingTotalLoad += load;
+        pendingSeconds += record.numSamples / rate;
+        pending.worstBlockMicros = juce::jmax(pending.worstBlockMicros, blockMicros);
+        pending.worstLoad = juce::jmax(pending.worstLoad, load);
+
+        for (size_t stage = 0; stage < NumStages; ++stage) {
+            const double stageMicros = record.stageTicks[stage] * microsPerTick;
+            pendingStageTotals[stage] += stageMicros;
+            pending.worstStageMicros[stage] = juce::jmax(pending.worstStageMicros[stage], stageMicros);
+        }
+
+        pending.activeVoices = record.activeVoices;
+        ++pending.numBlocks;
+    });
+
+    // Publish whole windows only, so a worst case isn't lost between two
+    // readers' polls; while nothing is playing the last window stays up
+    if (pendingSeconds < publishIntervalSecs) return;
+
+    pending.averageBlockMicros = pendingTotalMicros / pending.numBlocks;
+    pending.averageLoad = pendingTotalLoad / pending.numBlocks;
+    for (size_t stage = 0; stage < NumStages; ++stage) {
+        pending.averageStageMicros[stage] = pendingStageTotals[stage] / pending.numBlocks;
+    }
+    pending.numOverruns = getNumOverruns();
+
+    const auto sequence = publishSequence.load(std::memory_order_relaxed);
+    publishSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    published = pending;
+    publishSequence.store(sequence + 2, std::memory_order_release);
+
+    pending = {};
+    pendingTotalMicros = pendingTotalLoad = pendingSeconds = 0.0;
+    pendingStageTotals = {};
+}
+
+DspLoadMonitor::Summary DspLoadMonitor::getLatestSummary() const {
+    Summary summary;
+    for (;;) {
+        const auto before = publishSequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0) continue;  // Mid-publish; the writer is a few copies from done
+
+        summary = published;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (publishSequence.load(std::memory_order_relaxed) == before) break;
+    }
+
+    // The overrun count is kept live rather than per window
+    summary.numOverruns = getNumOverruns();
+    return summary;
+}
+
+const char* DspLoadMonitor::getStageName(Stage stage) {
+    switch (stage) {
+        case MidiDispatch:      return "MIDI";
+        case WavetableSynth:    return "Synth";
+        case SamplePlayback:    return "Sampler";
+        case Mix:               return "Mix";
+        case Chorus:            return "Chorus";
+        case Reverb:            return "Reverb";
+        case ConvolutionReverb: return "Convolution";
+        case NumStages:         break;
+    }
+    return "";
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+// Per-stage timing of processBlock. The audio thread stamps each stage with
+// the high-resolution tick counter and pushes one record per block into a
+// lock-free ring. The processor's timer is the ring's only consumer: update()
+// folds the records into averages and worst cases and publishes a summary
+// every publishIntervalSecs of audio, which any number of readers can poll
+// with getLatestSummary. Recording costs a couple of tick reads per stage and
+// never blocks or allocates.
+class DspLoadMonitor {
+public:
+    enum Stage {
+        MidiDispatch,
+        WavetableSynth,
+        SamplePlayback,
+        Mix,
+        Chorus,
+        Reverb,
+        ConvolutionReverb,
+        NumStages
+    };
+
+    struct Summary {
+        double averageBlockMicros = 0.0;
+        double worstBlockMicros = 0.0;
+        double averageLoad = 0.0;  // Fraction of the callback budget, 1.0 = all of it
+        double worstLoad = 0.0;
+        std::array<double, NumStages> averageStageMicros {};
+        std::array<double, NumStages> worstStageMicros {};
+        int activeVoices = 0;      // As of the latest block
+        int numOverruns = 0;       // Blocks that took longer than their budget, since prepare
+        int numBlocks = 0;         // Blocks in this summary
+    };
+
+    DspLoadMonitor();
+
+    void prepare(double sampleRate);
+
+    // Audio thread
+    void beginBlock(int numSamples);
+    void addStageTime(Stage stage, juce::int64 ticks) { current.stageTicks[static_cast<size_t>(stage)] += ticks; }
+    void endBlock(int activeVoices);
+
+    // Times the enclosing scope into one stage; stages may be entered repeatedly per block
+    class ScopedStage {
+    public:
+        ScopedStage(DspLoadMonitor& monitorToUse, Stage stageToTime)
+            : monitor(monitorToUse), stage(stageToTime), start(juce::Time::getHighResolutionTicks()) {}
+        ~ScopedStage() { monitor.addStageTime(stage, juce::Time::getHighResolutionTicks() - start); }
+
+    private:
+        DspLoadMonitor& monitor;
+        Stage stage;
+        juce::int64 start;
+        JUCE_DECLARE_NON_COPYABLE(ScopedStage)
+    };
+
+    // Consumer side; call from one thread only (the processor's timer)
+    void update();
+
+    // Any thread: the most recently published summary, left in place by the read
+    Summary getLatestSummary() const;
+
+    int getNumOverruns() const { return overruns.load(std::memory_order_relaxed); }
+
+    static const char* getStageName(Stage stage);
+
+private:
+    struct BlockRecord {
+        std::array<juce::int64, NumStages> stageTicks {};
+        juce::int64 totalTicks = 0;
+        int numSamples = 0;
+        int activeVoices = 0;
+    };
+
+    static constexpr int ringSize = 1024;  // About 10 s of 512-sample blocks at 48 kHz
+    juce::AbstractFifo fifo { ringSize };
+    std::array<BlockRecord, ringSize> records;
+
+    // Audio thread only
+    BlockRecord current;
+    juce::int64 blockStartTicks = 0;
+
+    std::atomic<double> sampleRate { 48000.0 };
+    std::atomic<int> overruns { 0 };
+
+    // Consumer only: blocks folded in since the last publish
+    Summary pending;
+    double pendingTotalMicros = 0.0, pendingTotalLoad = 0.0, pendingSeconds = 0.0;
+    std::array<double, NumStages> pendingStageTotals {};
+
+    // Seqlock around the published summary: odd while update() is writing it
+    std::atomic<juce::uint32> publishSequence { 0 };
+    Summary published;
+
+    static constexpr double publishIntervalSecs = 0.25;
+
+    const double microsPerTick;
+};
@@ -0,0 +1,280 @@
+#include "EffectsChain.h"
+
+void EffectSlot::prepareSlot(const juce::dsp::ProcessSpec& spec) {
+    sampleRate = spec.sampleRate;
+    prepare(spec);
+    reset();
+    sleeping = false;
+    silentInputSamples = 0;
+    quietOutputSamples = 0;
+}
+
+bool EffectSlot::isSilent(const juce::AudioBuffer<float>& buffer, int numSamples) {
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
+        if (buffer.getMagnitude(channel, 0, numSamples) > silenceThreshold) return false;
+    }
+    return true;
+}
+
+void EffectSlot::processSlot(juce::AudioBuffer<float>& buffer, int numSamples) {
+    // True bypass: the effect isn't run at all
+    if (bypassed.load(std::memory_order_relaxed)) {
+        wasBypassed = true;
+        idle.store(true, std::memory_order_relaxed);
+        return;
+    }
+    if (wasBypassed) {
+        wasBypassed = false;
+        reset();
+    }
+
+    const bool inputSilent = isSilent(buffer, numSamples);
+    if (sleeping) {
+        if (inputSilent) return;  // Silence in, silence out
+        sleeping = false;
+        idle.store(false, std::memory_order_relaxed);
+    }
+
+    process(buffer, numSamples);
+
+    if (!inputSilent) {
+        silentInputSamples = quietOutputSamples = 0;
+        return;
+    }
+
+    // Input has stopped: sleep once the output has been quiet for a while, or
+    // once the effect's whole tail has gone by regardless
+    silentInputSamples += numSamples;
+    quietOutputSamples = isSilent(buffer, numSamples) ? quietOutputSamples + numSamples : 0;
+
+    // An infinite tail (a frozen reverb) holds its output indefinitely, even
+    // while it's quiet, so such a slot never sleeps
+    const double tailSeconds = getTailLengthSeconds();
+    if (!std::isfinite(tailSeconds)) return;
+
+    const auto tailSamples = static_cast<juce::int64>(tailSeconds * sampleRate);
+    if (quietOutputSamples >= static_cast<juce::int64>(quietSecondsToSleep * sampleRate)
+        || silentInputSamples >= tailSamples + numSamples) {
+        sleeping = true;
+        idle.store(true, std::memory_order_relaxed);
+        reset();  // Whatever is left is below the threshold; start clean next time
+    }
+}
+
+void ChorusEffect::prepare(const juce::dsp::ProcessSpec& spec) {
+    chorus.prepare(spec);
+}
+
+void ChorusEffect::process(juce::AudioBuffer<float>& buffer, int numSamples) {
+    juce::dsp::AudioBlock<float> block(buffer);
+    auto subBlock = block.getSubBlock(0, static_cast<size_t>(numSamples));
+    chorus.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+}
+
+void ReverbEffect::prepare(const juce::dsp::ProcessSpec& spec) {
+    reverb.setSampleRate(spec.sampleRate);
+    updateTailLength();
+}
+
+void ReverbEffect::setParameters(const juce::Reverb::Parameters& newParameters) {
+    reverb.setParameters(newParameters);
+    updateTailLength();
+}
+
+void ReverbEffect::updateTailLength() {
+    const auto& params = reverb.getParameters();
+    if (params.freezeMode >= 0.5f) {
+        tailSeconds.store(std::numeric_limits<double>::infinity());
+        return;
+    }
+
+    // Freeverb's longest comb is 1617 samples at 44.1 kHz (plus stereo spread);
+    // RT60 follows from its feedback gain, which the room size sets
+    const double feedback = params.roomSize * 0.28 + 0.7;
+    const double combSeconds = (1617.0 + 23.0) / 44100.0;
+    const double rt60 = -3.0 * combSeconds / std::log10(feedback);
+    tailSeconds.store(params.wetLevel > 0.0f ? rt60 : 0.0);
+}
+
+void ReverbEffect::process(juce::AudioBuffer<float>& buffer, int numSamples) {
+    // One call per block: the reverb's state covers both channels together
+    if (buffer.getNumChannels() >= 2) {
+        reverb.processStereo(buffer.getWritePointer(0), buffer.getWritePointer(1), numSamples);
+    } else if (buffer.getNumChannels() == 1) {
+        reverb.processMono(buffer.getWritePointer(0), numSamples);
+    }
+}
+
+ConvolutionReverbEffect::~ConvolutionReverbEffect() {
+    if (convolver != nullptr) {
+        convolver->decReferenceCount();
+    }
+}
+
+PartitionedConvolver::Ptr ConvolutionReverbEffect::loadImpulseResponse(const juce::File& file) {
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->lengthInSamples <= 0) {
+        DBG("Couldn't read impulse response " << file.getFullPathName());
+        return nullptr;
+    }
+
+    const int numChannels = juce::jmin(static_cast<int>(reader->numChannels), PartitionedConvolver::maxChannels);
+    const int length = static_cast<int>(juce::jmin(reader->lengthInSamples,
+                                                   static_cast<juce::int64>(maxImpulseSeconds * reader->sampleRate)));
+    juce::AudioBuffer<float> loaded(numChannels, length);
+    reader->read(&loaded, 0, length, 0, true, numChannels > 1);
+
+    // Trailing near-silence would only cost tail partitions
+    float peak = 0.0f;
+    for (int channel = 0; channel < numChannels; ++channel) {
+        peak = juce::jmax(peak, loaded.getMagnitude(channel, 0, length));
+    }
+    if (peak <= 0.0f) {
+        DBG("Impulse response is silent: " << file.getFullPathName());
+        return nullptr;
+    }
+    int trimmedLength = length;
+    while (trimmedLength > 1) {
+        bool audible = false;
+        for (int channel = 0; channel < numChannels; ++channel) {
+            audible = audible || std::abs(loaded.getSample(channel, trimmedLength - 1)) > peak * 1.0e-4f;  // -80 dB
+        }
+        if (audible) break;
+        --trimmedLength;
+    }
+    loaded.setSize(numChannels, trimmedLength, true);
+
+    {
+        const juce::ScopedLock lock(impulseLock);
+        impulseResponse = std::move(loaded);
+        impulseSampleRate = reader->sampleRate;
+    }
+    return createConvolver(preparedSampleRate.load());
+}
+
+PartitionedConvolver::Ptr ConvolutionReverbEffect::createConvolver(double sampleRate) const {
+    const juce::ScopedLock lock(impulseLock);
+    if (impulseResponse.getNumSamples() == 0) return nullptr;
+
+    // Resample to the processing rate so the room sounds the same size at any rate
+    const double ratio = impulseSampleRate / sampleRate;
+    const int numChannels = impulseResponse.getNumChannels();
+    const int length = juce::jmax(1, static_cast<int>(std::ceil(impulseResponse.getNumSamples() / ratio)));
+    juce::AudioBuffer<float> resampled(numChannels, length);
+    for (int channel = 0; channel < numChannels; ++channel) {
+        if (ratio == 1.0) {
+            resampled.copyFrom(channel, 0, impulseResponse, channel, 0, length);
+        } else {
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process(ratio, impulseResponse.getReadPointer(channel), resampled.getWritePointer(channel),
+                                 length, impulseResponse.getNumSamples(), 0);
+        }
+    }
+
+    // Unit energy per channel, so swapping responses doesn't jump in level
+    double energy = 0.0;
+    for (int channel = 0; channel < numChannels; ++channel) {
+        const float* samples = resampled.getReadPointer(channel);
+        for (int i = 0; i < length; ++i) {
+            energy += static_cast<double>(samples[i]) * samples[i];
+        }
+    }
+    energy /= numChannels;
+    if (energy > 0.0) {
+        resampled.applyGain(static_cast<float>(1.0 / std::sqrt(energy)));
+    }
+
+    return new PartitionedConvolver(resampled, sampleRate);
+}
+
+PartitionedConvolver* ConvolutionReverbEffect::swapConvolver(PartitionedConvolver* newConvolver) {
+    if (newConvolver != nullptr && newConvolver->getSampleRate() != preparedSampleRate.load()) {
+        rebuildRequested.store(true);
+        return newConvolver;
+    }
+
+    auto* previous = convolver;
+    convolver = newConvolver;
+    tailSeconds.store(convolver != nullptr ? convolver->getLengthInSamples() / convolver->getSampleRate() : 0.0);
+    return previous;
+}
+
+void ConvolutionReverbEffect::prepare(const juce::dsp::ProcessSpec& spec) {
+    preparedSampleRate.store(spec.sampleRate);
+    wetBuffer.setSize(PartitionedConvolver::maxChannels, static_cast<int>(spec.maximumBlockSize));
+
+    // The audio callback isn't running, so a convolver for the old rate can be
+    // replaced and released right here
+    if (convolver != nullptr && convolver->getSampleRate() != spec.sampleRate) {
+        if (auto rebuilt = createConvolver(spec.sampleRate)) {
+            rebuilt->incReferenceCount();
+            if (auto* previous = swapConvolver(rebuilt.get())) {
+                previous->decReferenceCount();
+            }
+        }
+    }
+}
+
+void ConvolutionReverbEffect::reset() {
+    if (convolver != nullptr) {
+        convolver->reset();
+    }
+}
+
+void ConvolutionReverbEffect::process(juce::AudioBuffer<float>& buffer, int numSamples) {
+    if (convolver == nullptr || wetBuffer.getNumSamples() == 0) return;
+
+    const int numChannels = juce::jmin(buffer.getNumChannels(), PartitionedConvolver::maxChannels);
+    const int chunkCapacity = wetBuffer.getNumSamples();
+
+    // Dry signal stays at unity; the wet signal is added on top
+    for (int start = 0; start < numSamples; start += chunkCapacity) {
+        const int chunkSize = juce::jmin(chunkCapacity, numSamples - start);
+        const float* inputs[PartitionedConvolver::maxChannels] {};
+        float* outputs[PartitionedConvolver::maxChannels] {};
+        for (int channel = 0; channel < numChannels; ++channel) {
+            inputs[channel] = buffer.getReadPointer(channel, start);
+            outputs[channel] = wetBuffer.getWritePointer(channel);
+        }
+        convolver->process(inputs, outputs, numChannels, chunkSize);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            juce::FloatVectorOperations::addWithMultiply(buffer.getWritePointer(channel, start),
+                                                         wetBuffer.getReadPointer(channel), wetLevel, chunkSize);
+        }
+    }
+}
+
+void EffectsChain::prepare(const juce::dsp::ProcessSpec& spec) {
+    for (int i = 0; i < numSlots; ++i) {
+        slots[static_cast<size_t>(i)]->prepareSlot(spec);
+    }
+}
+
+void EffectsChain::process(juce::AudioBuffer<float>& buffer, int numSamples, DspLoadMonitor& monitor) {
+    for (int i = 0; i < numSlots; ++i) {
+        auto& slot = *slots[static_cast<size_t>(i)];
+        DspLoadMonitor::ScopedStage stage(monitor, slot.getStage());
+        slot.processSlot(buffer, numSamples);
+    }
+}
+
+double EffectsChain::getTailLengthSeconds() const {
+    double tail = 0.0;
+    for (int i = 0; i < numSlots; ++i) {
+        const auto& slot = *slots[static_cast<size_t>(i)];
+        if (!slot.isBypassed()) {
+            tail = juce::jmax(tail, slot.getTailLengthSeconds());
+        }
+    }
+    return tail;
+}
+
+bool EffectsChain::isIdle() const {
+    for (int i = 0; i < numSlots; ++i) {
+        if (!slots[static_cast<size_t>(i)]->isIdle()) return false;
+    }
+    return true;
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DspLoadMonitor.h"
+#include "PartitionedConvolver.h"
+#include <array>
+#include <atomic>
+#include <memory>
+
+// One effect in the chain. The base class owns the behaviour every slot shares:
+// a true bypass that skips processing altogether, and sleeping once the input
+// has gone silent and the effect's own tail has died away.
+class EffectSlot {
+public:
+    explicit EffectSlot(DspLoadMonitor::Stage stageToReport) : stage(stageToReport) {}
+    virtual ~EffectSlot() = default;
+
+    void prepareSlot(const juce::dsp::ProcessSpec& spec);
+    // Audio thread: runs the effect in place unless bypassed or asleep
+    void processSlot(juce::AudioBuffer<float>& buffer, int numSamples);
+
+    // Safe from any thread. The effect is reset when it comes back, so a stale
+    // tail never bursts out.
+    void setBypassed(bool shouldBypass) { bypassed.store(shouldBypass); }
+    bool isBypassed() const { return bypassed.load(); }
+
+    // True while the slot costs nothing: bypassed, or asleep on silence
+    bool isIdle() const { return idle.load(std::memory_order_relaxed); }
+
+    // How long the effect keeps ringing after its input stops
+    virtual double getTailLengthSeconds() const = 0;
+
+    DspLoadMonitor::Stage getStage() const { return stage; }
+
+protected:
+    virtual void prepare(const juce::dsp::ProcessSpec& spec) = 0;
+    virtual void reset() = 0;
+    virtual void process(juce::AudioBuffer<float>& buffer, int numSamples) = 0;
+
+private:
+    static bool isSilent(const juce::AudioBuffer<float>& buffer, int numSamples);
+
+    const DspLoadMonitor::Stage stage;
+    std::atomic<bool> bypassed { false };
+    std::atomic<bool> idle { false };
+
+    // Audio thread only
+    bool wasBypassed = false;
+    bool sleeping = false;
+    double sampleRate = 48000.0;
+    juce::int64 silentInputSamples = 0;   // Consecutive samples of silent input
+    juce::int64 quietOutputSamples = 0;   // ...during which the output was silent too
+
+    static constexpr float silenceThreshold = 1.0e-5f;  // -100 dBFS
+    static constexpr double quietSecondsToSleep = 0.1;
+};
+
+class ChorusEffect : public EffectSlot {
+public:
+    ChorusEffect() : EffectSlot(DspLoadMonitor::Chorus) {}
+
+    // Audio thread (through the engine command queue)
+    void setRate(float rateHz) { chorus.setRate(rateHz); }
+
+    double getTailLengthSeconds() const override { return 0.05; }  // Longest modulated delay plus margin
+
+protected:
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void reset() override { chorus.reset(); }
+    void process(juce::AudioBuffer<float>& buffer, int numSamples) override;
+
+private:
+    juce::dsp::Chorus<float> chorus;
+};
+
+class ReverbEffect : public EffectSlot {
+public:
+    ReverbEffect() : EffectSlot(DspLoadMonitor::Reverb) {}
+
+    // Audio thread (through the engine command queue)
+    void setParameters(const juce::Reverb::Parameters& newParameters);
+    const juce::Reverb::Parameters& getParameters() const { return reverb.getParameters(); }
+
+    double getTailLengthSeconds() const override { return tailSeconds.load(); }
+
+protected:
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void reset() override { reverb.reset(); }
+    void process(juce::AudioBuffer<float>& buffer, int numSamples) override;
+
+private:
+    void updateTailLength();
+
+    juce::Reverb reverb;
+    std::atomic<double> tailSeconds { 0.0 };
+};
+
+// Convolution with a recorded impulse response. The convolver is built off the
+// audio thread and swapped in between blocks; until one arrives the slot passes
+// its input through untouched.
+class ConvolutionReverbEffect : public EffectSlot {
+public:
+    ConvolutionReverbEffect() : EffectSlot(DspLoadMonitor::ConvolutionReverb) {}
+    ~ConvolutionReverbEffect() override;
+
+    // Any thread but the audio thread: reads an impulse response (up to
+    // maxImpulseSeconds, trimmed and normalised) and builds a convolver for the
+    // prepared sample rate. The response is kept so prepare() can rebuild at
+    // another rate. Returns nullptr if the file can't be read.
+    PartitionedConvolver::Ptr loadImpulseResponse(const juce::File& file);
+
+    // Audio thread (through the engine command queue): takes over one reference
+    // to newConvolver and returns the one it replaces, if any, with its reference.
+    // A convolver built for a rate other than the prepared one (its job started
+    // before a prepareToPlay) is handed straight back and a rebuild is requested.
+    PartitionedConvolver* swapConvolver(PartitionedConvolver* newConvolver);
+
+    // Message thread: true once after swapConvolver turned down a stale convolver;
+    // the caller then builds a replacement with rebuildConvolver off the audio thread
+    bool takeRebuildRequest() { return rebuildRequested.exchange(false); }
+    PartitionedConvolver::Ptr rebuildConvolver() const { return createConvolver(preparedSampleRate.load()); }
+    void setWetLevel(float level) { wetLevel = level; }
+
+    double getTailLengthSeconds() const override { return tailSeconds.load(); }
+
+    static constexpr double maxImpulseSeconds = 10.0;
+
+protected:
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void reset() override;
+    void process(juce::AudioBuffer<float>& buffer, int numSamples) override;
+
+private:
+    PartitionedConvolver::Ptr createConvolver(double sampleRate) const;
+
+    juce::CriticalSection impulseLock;  // Never taken on the audio thread
+    juce::AudioBuffer<float> impulseResponse;
+    double impulseSampleRate = 0.0;
+    std::atomic<double> preparedSampleRate { 48000.0 };
+    std::atomic<bool> rebuildRequested { false };
+
+    // Audio thread; holds one reference
+    PartitionedConvolver* convolver = nullptr;
+    juce::AudioBuffer<float> wetBuffer;
+    float wetLevel = 0.3f;
+    std::atomic<double> tailSeconds { 0.0 };
+};
+
+// Ordered list of effect slots applied to the mixed output. Slots are added
+// before prepareToPlay and keep their order; bypass can change at any time.
+class EffectsChain {
+public:
+    static constexpr int maxSlots = 8;
+
+    // Message thread, while the audio callback isn't running. Returns the slot
+    // for later control, or nullptr if the chain is full.
+    template <typename EffectType>
+    EffectType* addEffect(std::unique_ptr<EffectType> effect) {
+        if (numSlots == maxSlots) return nullptr;
+        auto* raw = effect.get();
+        slots[static_cast<size_t>(numSlots++)] = std::move(effect);
+        return raw;
+    }
+
+    int getNumSlots() const { return numSlots; }
+    EffectSlot* getSlot(int index) const { return slots[static_cast<size_t>(index)].get(); }
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    // Audio thread: each active slot in order, timed into its monitor stage
+    void process(juce::AudioBuffer<float>& buffer, int numSamples, DspLoadMonitor& monitor);
+
+    // Longest tail of the slots that aren't bypassed
+    double getTailLengthSeconds() const;
+
+    // True when every slot is bypassed or asleep, i.e. silence in gives silence out
+    bool isIdle() const;
+
+private:
+    std::array<std::unique_ptr<EffectSlot>, maxSlots> slots;
+    int numSlots = 0;
+};
@@ -0,0 +1,43 @@
+#include "EngineCommandQueue.h"
+
+EngineCommandQueue::~EngineCommandQueue() {
+    // The audio thread has stopped by now, so whatever is left can go here
+    const auto scope = commandFifo.read(commandFifo.getNumReady());
+    scope.forEach([this](int index) {
+        if (auto* object = commands[static_cast<size_t>(index)].object) {
+            object->decReferenceCount();
+        }
+    });
+    releaseRetired();
+}
+
+bool EngineCommandQueue::push(const EngineCommand& command) {
+    const juce::SpinLock::ScopedLockType lock(pushLock);
+    if (commandFifo.getFreeSpace() == 0) {
+        DBG("Engine command queue full; dropping command " << static_cast<int>(command.type));
+        return false;
+    }
+
+    if (command.object != nullptr) {
+        command.object->incReferenceCount();
+    }
+    const auto scope = commandFifo.write(1);
+    commands[static_cast<size_t>(scope.startIndex1)] = command;
+    return true;
+}
+
+void EngineCommandQueue::retire(juce::ReferenceCountedObject* object) {
+    if (object == nullptr) return;
+
+    // drain() only applies an object command when there's room for this
+    jassert(returnFifo.getFreeSpace() > 0);
+    const auto scope = returnFifo.write(1);
+    returns[static_cast<size_t>(scope.startIndex1)] = object;
+}
+
+void EngineCommandQueue::releaseRetired() {
+    const auto scope = returnFifo.read(returnFifo.getNumReady());
+    scope.forEach([this](int index) {
+        returns[static_cast<size_t>(index)]->decReferenceCount();
+    });
+}
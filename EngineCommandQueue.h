@@ -0,0 +1,78 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// One structural change for the audio engine, queued by the message thread
+struct EngineCommand {
+    enum Type {
+        SetWaveform,
+        SetUnisonSize,
+        SetDetuneAmount,
+        SetSynthVolume,
+        SetSampleVolume,
+        SetWavetableBank,
+        SetChorusRate,
+        SetReverbLevel,
+        SetConvolver,
+        SetConvolutionWetLevel,
+        SetGlobalLFO,
+        SetModulationRouting,
+        SetFilterMode
+    };
+
+    Type type = SetWaveform;
+    int intValue = 0;
+    float floatValue = 0.0f;
+    // Holds one reference while queued, which the audio thread takes over
+    juce::ReferenceCountedObject* object = nullptr;
+};
+
+// Lock-free (on the reading side) hand-over from the message thread to the
+// audio thread. Commands are applied between blocks, so engine state only ever
+// changes on the thread that reads it. Anything a command replaces goes back
+// through the return queue and is released on the message thread; nothing is
+// freed on the audio thread.
+class EngineCommandQueue {
+public:
+    EngineCommandQueue() = default;
+    ~EngineCommandQueue();
+
+    // Message thread or a background job; producers take turns on a lock the
+    // audio thread never touches. Adds a reference to command.object on the
+    // audio thread's behalf; returns false, taking none, if the queue is full.
+    bool push(const EngineCommand& command);
+
+    // Audio thread: applies every queued command in order. A command carrying an
+    // object is held back until there's room to return what it replaces.
+    template <typename Function>
+    void drain(Function&& apply) {
+        for (int numReady = commandFifo.getNumReady(); numReady > 0; --numReady) {
+            int start1, size1, start2, size2;
+            commandFifo.prepareToRead(1, start1, size1, start2, size2);
+            const auto& command = commands[static_cast<size_t>(start1)];
+            if (command.object != nullptr && returnFifo.getFreeSpace() == 0) break;
+
+            apply(command);
+            commandFifo.finishedRead(1);
+        }
+    }
+
+    // Audio thread, from inside drain(): hands back a reference for release
+    void retire(juce::ReferenceCountedObject* object);
+
+    // Message thread: drops the references the audio thread has handed back
+    void releaseRetired();
+
+private:
+    static constexpr int capacity = 256;
+
+    juce::SpinLock pushLock;
+    juce::AbstractFifo commandFifo { capacity };
+    std::array<EngineCommand, capacity> commands {};
+
+    juce::AbstractFifo returnFifo { capacity };
+    std::array<juce::ReferenceCountedObject*, capacity> returns {};
+
+    JUCE_DECLARE_NON_COPYABLE(EngineCommandQueue)
+};
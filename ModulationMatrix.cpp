@@ -0,0 +1,28 @@
+#include "ModulationMatrix.h"
+
+void ModulationMatrix::setRouting(int slot, Source source, Destination destination, float amount) {
+    if (!juce::isPositiveAndBelow(slot, maxRoutings)
+        || !juce::isPositiveAndBelow(static_cast<int>(source), static_cast<int>(NumSources))
+        || !juce::isPositiveAndBelow(static_cast<int>(destination), static_cast<int>(NumDestinations))) {
+        jassertfalse;
+        return;
+    }
+
+    auto& routing = slots[static_cast<size_t>(slot)];
+    if (routing.source == source && routing.destination == destination && routing.amount == amount) return;
+
+    routing = { source, destination, amount };
+    rebuildActiveList();
+}
+
+void ModulationMatrix::rebuildActiveList() {
+    numActive = 0;
+    sourceMask = destinationMask = 0;
+    for (const auto& routing : slots) {
+        if (routing.amount != 0.0f) {
+            active[static_cast<size_t>(numActive++)] = routing;
+            sourceMask |= 1u << routing.source;
+            destinationMask |= 1u << routing.destination;
+        }
+    }
+}
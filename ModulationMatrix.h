@@ -0,0 +1,53 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+// Sparse source -> destination routings shared by every voice of a synth.
+// Voices evaluate it at control rate; only routings with a non-zero amount are
+// kept in the active list, so an unused matrix costs nothing but a loop test.
+class ModulationMatrix {
+public:
+    enum Source { GlobalLFO, VoiceLFO, Envelope, Velocity, Note, NumSources };
+
+    // Units: cutoff in octaves, pitch and detune in semitones, volume as a
+    // fraction of full gain added to 1
+    enum Destination { Cutoff, Pitch, Volume, Detune, NumDestinations };
+
+    static constexpr int maxRoutings = 16;
+
+    ModulationMatrix() = default;
+
+    // Audio thread, between renders. An amount of zero removes the routing.
+    void setRouting(int slot, Source source, Destination destination, float amount);
+    void clearRouting(int slot) { setRouting(slot, GlobalLFO, Cutoff, 0.0f); }
+
+    int getNumActiveRoutings() const { return numActive; }
+    bool usesSource(Source source) const { return (sourceMask & (1u << source)) != 0; }
+    bool usesDestination(Destination destination) const { return (destinationMask & (1u << destination)) != 0; }
+
+    // sources holds NumSources values; destinations receives NumDestinations
+    // summed offsets
+    void process(const float* sources, float* destinations) const {
+        std::fill(destinations, destinations + NumDestinations, 0.0f);
+        for (int i = 0; i < numActive; ++i) {
+            const auto& routing = active[static_cast<size_t>(i)];
+            destinations[routing.destination] += sources[routing.source] * routing.amount;
+        }
+    }
+
+private:
+    struct Routing {
+        Source source = GlobalLFO;
+        Destination destination = Cutoff;
+        float amount = 0.0f;
+    };
+
+    void rebuildActiveList();
+
+    std::array<Routing, maxRoutings> slots {};
+    std::array<Routing, maxRoutings> active {};  // The non-zero slots, packed
+    int numActive = 0;
+    uint32_t sourceMask = 0;
+    uint32_t destinationMask = 0;
+};
@@ -0,0 +1,181 @@
+// Headless renderer: drives NewProjectAudioProcessor from a Standard MIDI File
+// with no host and writes the result to a WAV file, reporting how much faster
+// than real time it ran.
+//
+// This file is the whole of a separate console target. It's compiled out of
+// the plugin unless SYNTH_BUILD_OFFLINE_RENDERER=1; BUILDING.md has the target.
+//
+//   OfflineRenderer --midi song.mid --out stem.wav [--state preset.bin]
+//                   [--rate 48000] [--block 512] [--tail 2]
+#ifndef SYNTH_BUILD_OFFLINE_RENDERER
+ #define SYNTH_BUILD_OFFLINE_RENDERER 0
+#endif
+
+#if SYNTH_BUILD_OFFLINE_RENDERER
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include <iostream>
+
+namespace {
+
+struct RenderOptions {
+    juce::File midiFile;
+    juce::File outputFile;
+    juce::File stateFile;  // Output of getStateInformation; optional
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    double tailSeconds = 2.0;  // Rendered after the last MIDI event so releases ring out
+};
+
+void printUsage() {
+    std::cout << "Usage: OfflineRenderer --midi <file.mid> --out <file.wav> [--state <file>]\n"
+                 "                       [--rate <Hz>] [--block <samples>] [--tail <seconds>]\n";
+}
+
+bool parseArguments(const juce::StringArray& args, RenderOptions& options) {
+    const auto cwd = juce::File::getCurrentWorkingDirectory();
+
+    for (int i = 1; i < args.size(); ++i) {
+        const auto& arg = args[i];
+        const auto value = i + 1 < args.size() ? args[i + 1] : juce::String();
+
+        if (arg == "--midi")       { options.midiFile = cwd.getChildFile(value); ++i; }
+        else if (arg == "--out")   { options.outputFile = cwd.getChildFile(value); ++i; }
+        else if (arg == "--state") { options.stateFile = cwd.getChildFile(value); ++i; }
+        else if (arg == "--rate")  { options.sampleRate = value.getDoubleValue(); ++i; }
+        else if (arg == "--block") { options.blockSize = value.getIntValue(); ++i; }
+        else if (arg == "--tail")  { options.tailSeconds = value.getDoubleValue(); ++i; }
+        else {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            return false;
+        }
+    }
+
+    if (!options.midiFile.existsAsFile()) {
+        std::cerr << "MIDI file not found: " << options.midiFile.getFullPathName() << "\n";
+        return false;
+    }
+    if (options.outputFile == juce::File()) {
+        std::cerr << "No output file given\n";
+        return false;
+    }
+    if (options.sampleRate <= 0.0 || options.blockSize <= 0 || options.tailSeconds < 0.0) {
+        std::cerr << "Sample rate and block size must be positive, tail non-negative\n";
+        return false;
+    }
+    return true;
+}
+
+// Every track of the file merged into one sequence, timestamped in seconds
+bool readMidiFile(const juce::File& file, juce::MidiMessageSequence& sequence) {
+    juce::FileInputStream in(file);
+    juce::MidiFile midiFile;
+    if (!in.openedOk() || !midiFile.readFrom(in)) {
+        std::cerr << "Couldn't read MIDI file: " << file.getFullPathName() << "\n";
+        return false;
+    }
+
+    midiFile.convertTimestampTicksToSeconds();
+    for (int track = 0; track < midiFile.getNumTracks(); ++track) {
+        sequence.addSequence(*midiFile.getTrack(track), 0.0);
+    }
+    sequence.updateMatchedPairs();
+    return true;
+}
+
+bool loadState(NewProjectAudioProcessor& processor, const juce::File& file) {
+    juce::MemoryBlock state;
+    if (!file.loadFileAsData(state)) {
+        std::cerr << "Couldn't read state file: " << file.getFullPathName() << "\n";
+        return false;
+    }
+    processor.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+    return true;
+}
+
+int render(const RenderOptions& options) {
+    juce::MidiMessageSequence sequence;
+    if (!readMidiFile(options.midiFile, sequence)) return 1;
+
+    NewProjectAudioProcessor processor;
+    if (options.stateFile != juce::File() && !loadState(processor, options.stateFile)) return 1;
+
+    const int numChannels = processor.getTotalNumOutputChannels();
+    const double lengthSeconds = sequence.getEndTime() + options.tailSeconds;
+    const auto totalSamples = static_cast<juce::int64>(std::ceil(lengthSeconds * options.sampleRate));
+
+    options.outputFile.deleteFile();
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(
+        new juce::FileOutputStream(options.outputFile), options.sampleRate,
+        static_cast<unsigned int>(numChannels), 24, {}, 0));
+    if (writer == nullptr) {
+        std::cerr << "Couldn't create output file: " << options.outputFile.getFullPathName() << "\n";
+        return 1;
+    }
+
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+    processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+    juce::AudioBuffer<float> buffer(juce::jmax(numChannels, processor.getTotalNumInputChannels()), options.blockSize);
+    juce::MidiBuffer midi;
+    int nextEvent = 0;
+    juce::int64 processingTicks = 0;
+
+    for (juce::int64 blockStart = 0; blockStart < totalSamples; blockStart += options.blockSize) {
+        const int numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(options.blockSize), totalSamples - blockStart));
+        const double blockEndTime = static_cast<double>(blockStart + numSamples) / options.sampleRate;
+
+        // Events that fall inside this block, at their sample offsets
+        midi.clear();
+        for (; nextEvent < sequence.getNumEvents(); ++nextEvent) {
+            const auto& message = sequence.getEventPointer(nextEvent)->message;
+            if (message.getTimeStamp() >= blockEndTime) break;
+
+            const auto position = static_cast<juce::int64>(message.getTimeStamp() * options.sampleRate) - blockStart;
+            midi.addEvent(message, static_cast<int>(juce::jlimit(static_cast<juce::int64>(0), static_cast<juce::int64>(numSamples - 1), position)));
+        }
+
+        buffer.setSize(buffer.getNumChannels(), numSamples, false, false, true);
+        buffer.clear();
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        processor.processBlock(buffer, midi);
+        processingTicks += juce::Time::getHighResolutionTicks() - startTicks;
+
+        writer->writeFromAudioSampleBuffer(buffer, 0, numSamples);
+    }
+
+    processor.releaseResources();
+    writer.reset();
+
+    const double processingSeconds = juce::Time::highResolutionTicksToSeconds(processingTicks);
+    const double audioSeconds = static_cast<double>(totalSamples) / options.sampleRate;
+    std::cout << "Rendered " << audioSeconds << " s at " << options.sampleRate << " Hz, block "
+              << options.blockSize << ", in " << processingSeconds << " s of processBlock\n"
+              << "Real-time factor: " << (processingSeconds > 0.0 ? audioSeconds / processingSeconds : 0.0) << "x\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // The processor's timers and sample index expect a message manager to exist
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 0; i < argc; ++i) {
+        args.add(juce::String(juce::CharPointer_UTF8(argv[i])));
+    }
+
+    RenderOptions options;
+    if (!parseArguments(args, options)) {
+        printUsage();
+        return 1;
+    }
+    return render(options);
+}
+
+#endif
@@ -0,0 +1,30 @@
+#include "ParameterSnapshot.h"
+
+ParameterSnapshotSource::ParameterSnapshotSource(juce::AudioProcessorValueTreeState& apvts)
+    : mix(lookUp(apvts, "mix")),
+      filterCutoff(lookUp(apvts, "filterCutoff")),
+      filterResonance(lookUp(apvts, "filterResonance")),
+      lfoRate(lookUp(apvts, "lfoRate")),
+      lfoDepth(lookUp(apvts, "lfoDepth")),
+      attack(lookUp(apvts, "attack")),
+      decay(lookUp(apvts, "decay")),
+      sustain(lookUp(apvts, "sustain")),
+      release(lookUp(apvts, "release")) {}
+
+std::atomic<float>* ParameterSnapshotSource::lookUp(juce::AudioProcessorValueTreeState& apvts, const char* parameterID) {
+    auto* value = apvts.getRawParameterValue(parameterID);
+    jassert(value != nullptr);  // Every ID here must exist in createParameterLayout
+    return value;
+}
+
+void ParameterSnapshotSource::read(ParameterSnapshot& snapshot) const noexcept {
+    snapshot.mix = mix->load(std::memory_order_relaxed);
+    snapshot.filterCutoff = filterCutoff->load(std::memory_order_relaxed);
+    snapshot.filterResonance = filterResonance->load(std::memory_order_relaxed);
+    snapshot.lfoRate = lfoRate->load(std::memory_order_relaxed);
+    snapshot.lfoDepth = lfoDepth->load(std::memory_order_relaxed);
+    snapshot.attack = attack->load(std::memory_order_relaxed);
+    snapshot.decay = decay->load(std::memory_order_relaxed);
+    snapshot.sustain = sustain->load(std::memory_order_relaxed);
+    snapshot.release = release->load(std::memory_order_relaxed);
+}
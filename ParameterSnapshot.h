@@ -0,0 +1,40 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+// Plain copy of every automatable parameter, taken once at the top of
+// processBlock so the rest of the block works from consistent values.
+struct ParameterSnapshot {
+    float mix = 0.5f;
+    float filterCutoff = 2000.0f;
+    float filterResonance = 1.0f;
+    float lfoRate = 5.0f;
+    float lfoDepth = 0.5f;
+    float attack = 0.5f;
+    float decay = 1.0f;
+    float sustain = 0.8f;
+    float release = 1.5f;
+};
+
+// The APVTS raw-value atomics behind a ParameterSnapshot. They're looked up by
+// ID once on construction, so reading a snapshot never hashes a string.
+class ParameterSnapshotSource {
+public:
+    explicit ParameterSnapshotSource(juce::AudioProcessorValueTreeState& apvts);
+
+    void read(ParameterSnapshot& snapshot) const noexcept;
+
+private:
+    static std::atomic<float>* lookUp(juce::AudioProcessorValueTreeState& apvts, const char* parameterID);
+
+    std::atomic<float>* mix;
+    std::atomic<float>* filterCutoff;
+    std::atomic<float>* filterResonance;
+    std::atomic<float>* lfoRate;
+    std::atomic<float>* lfoDepth;
+    std::atomic<float>* attack;
+    std::atomic<float>* decay;
+    std::atomic<float>* sustain;
+    std::atomic<float>* release;
+};
@@ -0,0 +1,292 @@
+#include "PartitionedConvolver.h"
+
+namespace {
+    // acc += a * b over interleaved complex bins
+    void multiplyAccumulate(float* acc, const float* a, const float* b, int numBins) noexcept {
+        for (int bin = 0; bin < numBins; ++bin) {
+            const float ar = a[2 * bin], ai = a[2 * bin + 1];
+            const float br = b[2 * bin], bi = b[2 * bin + 1];
+            acc[2 * bin] += ar * br - ai * bi;
+            acc[2 * bin + 1] += ar * bi + ai * br;
+        }
+    }
+}
+
+void PartitionedConvolver::Stage::prepare(int newBlockSize, const juce::AudioBuffer<float>& ir, int irStart, int irEnd) {
+    blockSize = newBlockSize;
+    numBins = blockSize + 1;
+    numPartitions = juce::jmax(0, (irEnd - irStart + blockSize - 1) / blockSize);
+    fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(2 * blockSize)));
+    fftBuffer.assign(static_cast<size_t>(4 * blockSize), 0.0f);
+    accumulator.assign(static_cast<size_t>(2 * numBins), 0.0f);
+
+    const size_t spectrumSize = static_cast<size_t>(2 * numBins);
+    for (int channel = 0; channel < maxChannels; ++channel) {
+        auto& partitions = filter[static_cast<size_t>(channel)];
+        partitions.assign(spectrumSize * static_cast<size_t>(numPartitions), 0.0f);
+        delayLine[static_cast<size_t>(channel)].assign(partitions.size(), 0.0f);
+
+        // Each partition is zero-padded to twice its length, as overlap-save needs
+        const float* source = ir.getReadPointer(juce::jmin(channel, ir.getNumChannels() - 1));
+        for (int partition = 0; partition < numPartitions; ++partition) {
+            const int start = irStart + partition * blockSize;
+            const int length = juce::jmin(blockSize, irEnd - start);
+            std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+            std::copy(source + start, source + start + length, fftBuffer.begin());
+            fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+            std::copy(fftBuffer.begin(), fftBuffer.begin() + static_cast<std::ptrdiff_t>(spectrumSize),
+                      partitions.begin() + static_cast<std::ptrdiff_t>(spectrumSize * static_cast<size_t>(partition)));
+        }
+    }
+    clear();
+}
+
+void PartitionedConvolver::Stage::clear() {
+    for (auto& spectra : delayLine) {
+        std::fill(spectra.begin(), spectra.end(), 0.0f);
+    }
+    delayLineIndex = 0;
+}
+
+void PartitionedConvolver::Stage::processBlock(int channel, const float* input, float* output) {
+    if (numPartitions == 0) {
+        std::fill(output, output + blockSize, 0.0f);
+        return;
+    }
+
+    const int spectrumSize = 2 * numBins;
+    std::copy(input, input + 2 * blockSize, fftBuffer.begin());
+    std::fill(fftBuffer.begin() + 2 * blockSize, fftBuffer.end(), 0.0f);
+    fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+    float* spectra = delayLine[static_cast<size_t>(channel)].data();
+    std::copy(fftBuffer.begin(), fftBuffer.begin() + spectrumSize, spectra + delayLineIndex * spectrumSize);
+
+    // Newest input against the first partition, oldest against the last
+    const float* partitions = filter[static_cast<size_t>(channel)].data();
+    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+    for (int partition = 0; partition < numPartitions; ++partition) {
+        const int age = (delayLineIndex - partition + numPartitions) % numPartitions;
+        multiplyAccumulate(accumulator.data(), spectra + age * spectrumSize, partitions + partition * spectrumSize, numBins);
+    }
+
+    // Only the second half of the circular result is free of wrap-around
+    std::copy(accumulator.begin(), accumulator.end(), fftBuffer.begin());
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
+    std::copy(fftBuffer.begin() + blockSize, fftBuffer.begin() + 2 * blockSize, output);
+}
+
+void PartitionedConvolver::Stage::advance() {
+    if (numPartitions > 0) {
+        delayLineIndex = (delayLineIndex + 1) % numPartitions;
+    }
+}
+
+PartitionedConvolver::PartitionedConvolver(const juce::AudioBuffer<float>& impulseResponse, double rate)
+    : juce::Thread("Convolution tail"),
+      sampleRate(rate),
+      lengthInSamples(impulseResponse.getNumSamples()),
+      numIrChannels(juce::jlimit(1, maxChannels, impulseResponse.getNumChannels())) {
+    jassert(impulseResponse.getNumChannels() > 0);
+
+    // Stored back to front so the FIR walks both arrays forwards
+    const int numDirect = juce::jmin(directLength, lengthInSamples);
+    for (int channel = 0; channel < maxChannels; ++channel) {
+        const float* source = impulseResponse.getReadPointer(juce::jmin(channel, numIrChannels - 1));
+        for (int tap = 0; tap < numDirect; ++tap) {
+            reversedDirect[static_cast<size_t>(channel)][static_cast<size_t>(directLength - 1 - tap)] = source[tap];
+        }
+    }
+
+    head.prepare(headBlockSize, impulseResponse, directLength, juce::jmin(lengthInSamples, headEnd));
+    hasTail = lengthInSamples > headEnd;
+    if (hasTail) {
+        tail.prepare(tailBlockSize, impulseResponse, headEnd, lengthInSamples);
+    }
+
+    headInput.clear();
+    headOutput.clear();
+    tailInput.clear();
+    tailOutput.clear();
+    workerPrevious.clear();
+
+    if (hasTail) {
+        // A missed deadline is an audible hole in the tail
+        startThread(juce::Thread::Priority::high);
+    }
+}
+
+PartitionedConvolver::~PartitionedConvolver() {
+    stopThread(1000);
+}
+
+void PartitionedConvolver::reset() {
+    headInput.clear();
+    headOutput.clear();
+    tailInput.clear();
+    tailOutput.clear();
+    head.clear();
+    headPosition = tailPosition = 0;
+    tailSequence = 0;
+
+    // The worker sees the new epoch on the next block and starts over itself
+    ++epoch;
+    for (auto& slot : slots) {
+        if (slot.state.load(std::memory_order_acquire) == Done) {
+            slot.state.store(Free, std::memory_order_relaxed);
+        }
+    }
+}
+
+void PartitionedConvolver::process(const float* const* inputs, float* const* outputs, int numChannels, int numSamples) {
+    numChannels = juce::jmin(numChannels, maxChannels);
+
+    // Work in stretches that end on head block boundaries; tail blocks are a
+    // whole number of head blocks, so their boundaries fall on the same places
+    int done = 0;
+    while (done < numSamples) {
+        const int chunkSize = juce::jmin(numSamples - done, headBlockSize - headPosition);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const float* input = inputs[channel] + done;
+            float* output = outputs[channel] + done;
+            float* history = headInput.getWritePointer(channel);  // [previous block, current block]
+            std::copy(input, input + chunkSize, history + headBlockSize + headPosition);
+            std::copy(input, input + chunkSize, tailInput.getWritePointer(channel) + tailPosition);
+
+            const float* direct = reversedDirect[static_cast<size_t>(channel)].data();
+            const float* headResult = headOutput.getReadPointer(channel) + headPosition;
+            const float* tailResult = tailOutput.getReadPointer(channel) + tailPosition;
+            for (int i = 0; i < chunkSize; ++i) {
+                const float* window = history + headBlockSize + headPosition + i - (directLength - 1);
+                float sum = 0.0f;
+                for (int tap = 0; tap < directLength; ++tap) {
+                    sum += direct[tap] * window[tap];
+                }
+                output[i] = sum + headResult[i] + tailResult[i];
+            }
+        }
+
+        done += chunkSize;
+        headPosition += chunkSize;
+        tailPosition += chunkSize;
+
+        if (headPosition == headBlockSize) {
+            processHeadBlock(numChannels);
+            headPosition = 0;
+        }
+        if (tailPosition == tailBlockSize) {
+            finishTailBlock(numChannels);
+            tailPosition = 0;
+        }
+    }
+}
+
+// The head stage's taps start one block in, so the block just completed
+// contributes from the next block on: exactly the samples computed here
+void PartitionedConvolver::processHeadBlock(int numChannels) {
+    for (int channel = 0; channel < numChannels; ++channel) {
+        float* history = headInput.getWritePointer(channel);
+        head.processBlock(channel, history, headOutput.getWritePointer(channel));
+        std::copy(history + headBlockSize, history + 2 * headBlockSize, history);
+    }
+    head.advance();
+}
+
+// Hands the finished tail block to the worker and picks up the one before it,
+// which is due from now on
+void PartitionedConvolver::finishTailBlock(int numChannels) {
+    if (!hasTail) return;
+
+    auto& submit = slots[tailSequence % slots.size()];
+    int state = submit.state.load(std::memory_order_acquire);
+    if (state == Done) {
+        state = Free;  // A result that came back too late to be played
+    }
+    if (state == Free) {
+        for (int channel = 0; channel < maxChannels; ++channel) {
+            submit.input.copyFrom(channel, 0, tailInput, juce::jmin(channel, numChannels - 1), 0, tailBlockSize);
+        }
+        submit.sequence = tailSequence;
+        submit.epoch = epoch;
+        submit.state.store(Submitted, std::memory_order_release);
+        notify();
+    } else {
+        // The worker still has the block from three periods ago; this one is lost
+        tailUnderruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    tailOutput.clear();
+    if (tailSequence > 0) {
+        const uint32_t due = tailSequence - 1;
+        auto& result = slots[due % slots.size()];
+        if (result.state.load(std::memory_order_acquire) == Done && result.sequence == due && result.epoch == epoch) {
+            for (int channel = 0; channel < numChannels; ++channel) {
+                tailOutput.copyFrom(channel, 0, result.output, channel, 0, tailBlockSize);
+            }
+            result.state.store(Free, std::memory_order_release);
+        } else {
+            tailUnderruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    ++tailSequence;
+}
+
+void PartitionedConvolver::run() {
+    while (!threadShouldExit()) {
+        // Oldest submitted block first; there are never more than two waiting
+        TailSlot* next = nullptr;
+        for (auto& slot : slots) {
+            if (slot.state.load(std::memory_order_acquire) != Submitted) continue;
+
+            // Submitted before a reset: nobody will collect it, and running it
+            // after the new epoch's blocks would throw away their tail state
+            if (slot.epoch != epoch.load(std::memory_order_acquire)) {
+                slot.state.store(Done, std::memory_order_release);
+                continue;
+            }
+            if (next == nullptr || slot.sequence < next->sequence) {
+                next = &slot;
+            }
+        }
+
+        if (next == nullptr) {
+            wait(-1);
+            continue;
+        }
+        processTailSlot(*next);
+        next->state.store(Done, std::memory_order_release);
+    }
+}
+
+void PartitionedConvolver::processTailSlot(TailSlot& slot) {
+    if (slot.epoch != workerEpoch || slot.sequence < workerNextSequence) {
+        // The audio thread reset: forget everything heard before
+        workerEpoch = slot.epoch;
+        workerNextSequence = slot.sequence;
+        tail.clear();
+        workerPrevious.clear();
+    }
+
+    // Blocks the audio thread couldn't submit go through as silence, so the
+    // delay line stays in step with real time
+    const uint32_t skipped = juce::jmin(slot.sequence - workerNextSequence, static_cast<uint32_t>(tail.numPartitions + 1));
+    for (uint32_t i = 0; i < skipped; ++i) {
+        workerInput.clear();
+        for (int channel = 0; channel < maxChannels; ++channel) {
+            workerInput.copyFrom(channel, 0, workerPrevious, channel, 0, tailBlockSize);
+            tail.processBlock(channel, workerInput.getReadPointer(channel), slot.output.getWritePointer(channel));
+        }
+        tail.advance();
+        workerPrevious.clear();
+    }
+
+    for (int channel = 0; channel < maxChannels; ++channel) {
+        workerInput.copyFrom(channel, 0, workerPrevious, channel, 0, tailBlockSize);
+        workerInput.copyFrom(channel, tailBlockSize, slot.input, channel, 0, tailBlockSize);
+        tail.processBlock(channel, workerInput.getReadPointer(channel), slot.output.getWritePointer(channel));
+        workerPrevious.copyFrom(channel, 0, slot.input, channel, 0, tailBlockSize);
+    }
+    tail.advance();
+    workerNextSequence = slot.sequence + 1;
+}
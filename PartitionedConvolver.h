@@ -0,0 +1,113 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Zero-latency convolution with a long impulse response, split three ways:
+//
+//   taps [0, 128)        direct-form FIR, sample by sample on the audio thread
+//   taps [128, 4096)     uniformly partitioned overlap-save, 128-sample blocks
+//                        (256-point FFTs), also on the audio thread
+//   taps [4096, end)     2048-sample partitions (4096-point FFTs) computed on
+//                        a worker thread
+//
+// Each stage starts where the previous one's latency ends, so nothing is
+// delayed. A tail block handed to the worker isn't heard until a full block
+// period later, which is the worker's deadline; if it misses it, that block's
+// tail is left out and counted rather than waited for. Three hand-over slots
+// let one block be in flight while another is played and a third is filled.
+class PartitionedConvolver : public juce::ReferenceCountedObject,
+                             private juce::Thread {
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<PartitionedConvolver>;
+
+    static constexpr int maxChannels = 2;
+    static constexpr int directLength = 128;
+    static constexpr int headBlockSize = 128;
+    static constexpr int tailBlockSize = 2048;
+    static constexpr int headEnd = 2 * tailBlockSize;  // Gives the worker one block of lookahead
+
+    // impulseResponse: one or two channels at the processing sample rate. A mono
+    // response is used for both channels. Starts the worker thread.
+    PartitionedConvolver(const juce::AudioBuffer<float>& impulseResponse, double sampleRate);
+    ~PartitionedConvolver() override;
+
+    // Audio thread: writes the convolution of numChannels inputs into outputs.
+    // Inputs and outputs may be the same buffers.
+    void process(const float* const* inputs, float* const* outputs, int numChannels, int numSamples);
+
+    // Audio thread: forgets all past input. Tail blocks still with the worker
+    // are discarded when they come back.
+    void reset();
+
+    int getLengthInSamples() const { return lengthInSamples; }
+    double getSampleRate() const { return sampleRate; }
+    int getNumTailUnderruns() const { return tailUnderruns.load(std::memory_order_relaxed); }
+
+private:
+    // Frequency-domain partitions and delay line for one uniformly partitioned stage
+    struct Stage {
+        int blockSize = 0;
+        int numBins = 0;        // blockSize + 1 complex values
+        int numPartitions = 0;
+        std::array<std::vector<float>, maxChannels> filter;      // numPartitions spectra
+        std::array<std::vector<float>, maxChannels> delayLine;   // The last numPartitions input spectra
+        int delayLineIndex = 0;
+        std::unique_ptr<juce::dsp::FFT> fft;
+        std::vector<float> fftBuffer;    // 2 * fftSize floats, as juce::dsp::FFT wants
+        std::vector<float> accumulator;  // numBins complex values
+
+        void prepare(int newBlockSize, const juce::AudioBuffer<float>& ir, int irStart, int irEnd);
+        void clear();
+        // input: [previous block, current block]; output: blockSize samples
+        void processBlock(int channel, const float* input, float* output);
+        void advance();  // After every channel has processed the block
+    };
+
+    enum SlotState { Free, Submitted, Done };
+
+    struct TailSlot {
+        std::atomic<int> state { Free };
+        uint32_t sequence = 0;
+        uint32_t epoch = 0;
+        juce::AudioBuffer<float> input { maxChannels, tailBlockSize };
+        juce::AudioBuffer<float> output { maxChannels, tailBlockSize };
+    };
+
+    void processHeadBlock(int numChannels);
+    void finishTailBlock(int numChannels);
+    void run() override;
+    void processTailSlot(TailSlot& slot);
+
+    const double sampleRate;
+    int lengthInSamples = 0;
+    int numIrChannels = 1;
+
+    // Audio thread
+    std::array<std::array<float, directLength>, maxChannels> reversedDirect {};
+    juce::AudioBuffer<float> headInput { maxChannels, 2 * headBlockSize };  // [previous, current]
+    juce::AudioBuffer<float> headOutput { maxChannels, headBlockSize };
+    juce::AudioBuffer<float> tailInput { maxChannels, tailBlockSize };
+    juce::AudioBuffer<float> tailOutput { maxChannels, tailBlockSize };
+    int headPosition = 0;
+    int tailPosition = 0;
+    uint32_t tailSequence = 0;
+    Stage head;
+    bool hasTail = false;
+
+    // Shared with the worker through each slot's state
+    std::array<TailSlot, 3> slots;
+    std::atomic<uint32_t> epoch { 0 };  // Written by the audio thread on reset()
+    std::atomic<int> tailUnderruns { 0 };
+
+    // Worker thread
+    Stage tail;
+    juce::AudioBuffer<float> workerPrevious { maxChannels, tailBlockSize };
+    juce::AudioBuffer<float> workerInput { maxChannels, 2 * tailBlockSize };
+    uint32_t workerEpoch = 0;
+    uint32_t workerNextSequence = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(PartitionedConvolver)
+};
@@ -10,10 +10,36 @@ NewProjectAudioProcessorEditor::NewProjectAudioProcessorEditor(NewProjectAudioPr
     setupLFControls();
     setupVolumeSlider();
     setupEffectControls();
+    setupLoadDisplay();
 }
 
 NewProjectAudioProcessorEditor::~NewProjectAudioProcessorEditor() {
-    // Clean up any resources if necessary
+    stopTimer();
+}
+
+void NewProjectAudioProcessorEditor::setupLoadDisplay() {
+    loadLabel.setBounds(10, 5, getWidth() - 20, 36);
+    loadLabel.setFont(juce::Font(12.0f));
+    loadLabel.setJustificationType(juce::Justification::topLeft);
+    addAndMakeVisible(loadLabel);
+    startTimerHz(4);
+}
+
+void NewProjectAudioProcessorEditor::timerCallback() {
+    const auto summary = audioProcessor.getLoadMonitor().getLatestSummary();
+
+    juce::String text;
+    text << "DSP " << juce::roundToInt(summary.averageLoad * 100.0) << "% avg, "
+         << juce::roundToInt(summary.worstLoad * 100.0) << "% worst ("
+         << juce::String(summary.worstBlockMicros / 1000.0, 2) << " ms)  |  "
+         << summary.activeVoices << " voices  |  " << summary.numOverruns << " overruns\n";
+
+    // Average time per stage, so a crackle can be pinned on one of them
+    for (int stage = 0; stage < DspLoadMonitor::NumStages; ++stage) {
+        text << DspLoadMonitor::getStageName(static_cast<DspLoadMonitor::Stage>(stage)) << " "
+             << juce::String(summary.averageStageMicros[static_cast<size_t>(stage)], 0) << "us  ";
+    }
+    loadLabel.setText(text, juce::dontSendNotification);
 }
 
 void NewProjectAudioProcessorEditor::setupADSRControls() {
@@ -34,7 +60,7 @@ void NewProjectAudioProcessorEditor::setupEffectControls() {
 
 void NewProjectAudioProcessorEditor::setupUnisonControls() {
     const int startY = 400;
-    setupSlider(unisonSizeSlider, unisonSizeLabel, "Unison Size", " Voices", 1, 8, 1, startY);
+    setupSlider(unisonSizeSlider, unisonSizeLabel, "Unison Size", " Voices", 1, UnisonOscillator::maxLayers, 1, startY);
     setupSlider(unisonDetuneSlider, unisonDetuneLabel, "Unison Detune", " Semitones", 0.0, 0.5, 0.01, startY + 45);
 }
 
@@ -80,9 +106,9 @@ void NewProjectAudioProcessorEditor::sliderValueChanged(juce::Slider* slider) {
     if (slider == &volumeSlider) {
         audioProcessor.setVolume(slider->getValue());
     } else if (slider == &reverbLevelSlider) {
-        // Implement the action when reverb level changes
+        audioProcessor.setReverbLevel(static_cast<float>(slider->getValue()));
     } else if (slider == &chorusRateSlider) {
-        // Implement the action when chorus rate changes
+        audioProcessor.setChorusRate(static_cast<float>(slider->getValue()));
     }
     
 }
@@ -7,7 +7,8 @@
 
 class NewProjectAudioProcessor; // Forward declaration
 
-class NewProjectAudioProcessorEditor : public juce::AudioProcessorEditor, public juce::Slider::Listener {
+class NewProjectAudioProcessorEditor : public juce::AudioProcessorEditor, public juce::Slider::Listener,
+                                       private juce::Timer {
 public:
     explicit NewProjectAudioProcessorEditor(NewProjectAudioProcessor&);
     ~NewProjectAudioProcessorEditor() override;
@@ -32,6 +33,7 @@ public:
     void setupADSRControls();
     void setupEffectControls();
     void setupVolumeSlider();
+    void setupLoadDisplay();
     
     void setupSlider(juce::Slider& slider, juce::Label& label, const juce::String& text,
                          const juce::String& suffix, float start, float end, float interval, int yPos);
@@ -76,6 +78,10 @@ private:
     juce::Label reverbLevelLabel;
     juce::Label chorusRateLabel;
 
+    // DSP load readout, refreshed from the processor's DspLoadMonitor
+    juce::Label loadLabel;
+    void timerCallback() override;
+
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NewProjectAudioProcessorEditor)
 };
@@ -2,6 +2,7 @@
 #include "PluginEditor.h"
 #include "Sampler.h"
 #include "SynthVoice.h"
+#include "AllocationTripwire.h"
 #include <juce_core/juce_core.h>
 #include <juce_dsp/juce_dsp.h>
 
@@ -10,7 +11,12 @@ NewProjectAudioProcessor::NewProjectAudioProcessor()
                                 .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
   apvts(*this, nullptr, "PARAMETERS", createParameterLayout())
 {
-    initializeSampleDirectory();  // Correctly placed within the constructor body
+    chorusEffect = effects.addEffect(std::make_unique<ChorusEffect>());
+    reverbEffect = effects.addEffect(std::make_unique<ReverbEffect>());
+    convolutionEffect = effects.addEffect(std::make_unique<ConvolutionReverbEffect>());
+
+    initializeSampleDirectory();
+    startTimer(100);  // Correctly placed within the constructor body
 }
 
 
@@ -33,19 +39,16 @@ juce::AudioProcessorValueTreeState::ParameterLayout NewProjectAudioProcessor::cr
 
 
 void NewProjectAudioProcessor::initializeSampleDirectory() {
-    juce::File appDataDir = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory);
-    juce::File sampleDir = appDataDir.getChildFile("NewProject/SAMPLES");
-    if (!sampleDir.exists()) {
-        sampleDir.createDirectory();
-    }
-    // Continue with your file operations
+    // Creates the directory if needed, then brings the shared index up to date in
+    // the background; instances after the first find it mostly current already
+    scanSamplesDirectory(SampleLibraryIndex::getDefaultDirectory().getFullPathName());
 }
 
 
 
 
 NewProjectAudioProcessor::~NewProjectAudioProcessor() {
-    // Perform any necessary cleanup if required
+    stopTimer();
 }
 
 const juce::String NewProjectAudioProcessor::getName() const {
@@ -65,7 +68,11 @@ bool NewProjectAudioProcessor::isMidiEffect() const {
 }
 
 double NewProjectAudioProcessor::getTailLengthSeconds() const {
-    return 0.0;
+    // After the last note-off: the longest voice release, then whatever the
+    // active effects keep ringing (infinite for a frozen reverb)
+    ParameterSnapshot current;
+    parameterSource.read(current);
+    return current.release + effects.getTailLengthSeconds();
 }
 
 int NewProjectAudioProcessor::getNumPrograms() {
@@ -121,35 +128,197 @@ void NewProjectAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBl
     }
     wavetableSynth.prepareToPlay(sampleRate, samplesPerBlock);
     sampler.prepareToPlay(sampleRate, samplesPerBlock);
+
+    // Start from the current values so nothing glides in on the first block
+    parameterSource.read(parameters);
+    mixSmoother.reset(sampleRate, parameterSmoothingSecs);
+    mixSmoother.setCurrentAndTargetValue(parameters.mix);
+    sustainSmoother.reset(sampleRate, parameterSmoothingSecs);
+    sustainSmoother.setCurrentAndTargetValue(parameters.sustain);
+    appliedEnvelope = {};
+    applyParameters(0);
+
+    const int numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+    synthScratchBuffer.setSize(numChannels, samplesPerBlock);
+    samplerScratchBuffer.setSize(numChannels, samplesPerBlock);
+
+    loadMonitor.prepare(sampleRate);
+    effects.prepare({ sampleRate, static_cast<juce::uint32>(samplesPerBlock), static_cast<juce::uint32>(numChannels) });
 }
 
 void NewProjectAudioProcessor::releaseResources() {
     wavetableSynth.releaseResources();
     sampler.releaseResources();
+
+    if (AllocationTripwire::getNumViolations() > 0) {
+        DBG(AllocationTripwire::getReport());
+    }
 }
 
 void NewProjectAudioProcessor::setWaveform(int type) {
     if (type >= 0 && type < static_cast<int>(WavetableSynthesizer::Waveform::NumWaveforms)) {
-        wavetableSynth.setWaveform(static_cast<WavetableSynthesizer::Waveform>(type));
+        commandQueue.push({ EngineCommand::SetWaveform, type });
     } else {
         DBG("Invalid waveform type specified");
     }
 }
 
 void NewProjectAudioProcessor::setSynthVolume(float volume) {
-    wavetableSynth.setVolume(volume);
+    commandQueue.push({ EngineCommand::SetSynthVolume, 0, volume });
 }
 
 void NewProjectAudioProcessor::setSampleVolume(float volume) {
-    sampler.setVolume(volume);
+    commandQueue.push({ EngineCommand::SetSampleVolume, 0, volume });
 }
 
 void NewProjectAudioProcessor::setUnisonSize(int size) {
-    wavetableSynth.setUnisonSize(size);  
+    commandQueue.push({ EngineCommand::SetUnisonSize, size });
 }
 
 void NewProjectAudioProcessor::setDetuneAmount(float amount) {
-    wavetableSynth.setDetuneAmount(amount);
+    commandQueue.push({ EngineCommand::SetDetuneAmount, 0, amount });
+}
+
+void NewProjectAudioProcessor::setChorusRate(float rateHz) {
+    commandQueue.push({ EngineCommand::SetChorusRate, 0, rateHz });
+}
+
+void NewProjectAudioProcessor::setReverbLevel(float wetLevel) {
+    commandQueue.push({ EngineCommand::SetReverbLevel, 0, juce::jlimit(0.0f, 1.0f, wetLevel) });
+}
+
+void NewProjectAudioProcessor::setConvolutionWetLevel(float wetLevel) {
+    commandQueue.push({ EngineCommand::SetConvolutionWetLevel, 0, juce::jlimit(0.0f, 1.0f, wetLevel) });
+}
+
+void NewProjectAudioProcessor::loadImpulseResponse(const juce::String& fileName) {
+    const auto file = juce::File::isAbsolutePath(fileName) ? juce::File(fileName)
+                                                           : SampleLibraryIndex::getDefaultDirectory().getChildFile(fileName);
+    if (!file.existsAsFile()) {
+        DBG("Impulse response does not exist: " + file.getFullPathName());
+        return;
+    }
+
+    // Decoding, resampling and transforming the partitions can take a while
+    backgroundJobs.addJob([this, file] {
+        if (auto convolver = convolutionEffect->loadImpulseResponse(file)) {
+            commandQueue.push({ EngineCommand::SetConvolver, 0, 0.0f, convolver.get() });
+        }
+    });
+}
+
+void NewProjectAudioProcessor::setEffectBypassed(int slotIndex, bool shouldBypass) {
+    if (juce::isPositiveAndBelow(slotIndex, effects.getNumSlots())) {
+        effects.getSlot(slotIndex)->setBypassed(shouldBypass);
+    }
+}
+
+void NewProjectAudioProcessor::setModulationRouting(int slot, ModulationMatrix::Source source,
+                                                    ModulationMatrix::Destination destination, float amount) {
+    if (!juce::isPositiveAndBelow(slot, ModulationMatrix::maxRoutings) || slot == WavetableSynthesizer::lfoDepthRouting) {
+        DBG("Invalid modulation slot " << slot);
+        return;
+    }
+    // Slot, source and destination all fit in one int: 8 bits each
+    const int packed = slot | (static_cast<int>(source) << 8) | (static_cast<int>(destination) << 16);
+    commandQueue.push({ EngineCommand::SetModulationRouting, packed, amount });
+}
+
+void NewProjectAudioProcessor::setFilterMode(SVFFilterBank::Mode mode) {
+    if (juce::isPositiveAndBelow(static_cast<int>(mode), static_cast<int>(SVFFilterBank::NumModes))) {
+        commandQueue.push({ EngineCommand::SetFilterMode, static_cast<int>(mode) });
+    }
+}
+
+void NewProjectAudioProcessor::setGlobalLFO(TableLFO::Shape shape, float rateHz) {
+    commandQueue.push({ EngineCommand::SetGlobalLFO, static_cast<int>(shape), rateHz });
+}
+
+void NewProjectAudioProcessor::setWavetableBank(WavetableBank::Ptr bank) {
+    if (bank != nullptr) {
+        commandQueue.push({ EngineCommand::SetWavetableBank, 0, 0.0f, bank.get() });
+    }
+}
+
+// Audio thread, between blocks: the only place engine structure changes
+void NewProjectAudioProcessor::applyCommand(const EngineCommand& command) {
+    switch (command.type) {
+        case EngineCommand::SetWaveform:
+            wavetableSynth.setWaveform(static_cast<WavetableSynthesizer::Waveform>(command.intValue));
+            break;
+        case EngineCommand::SetUnisonSize:
+            wavetableSynth.setUnisonSize(command.intValue);
+            break;
+        case EngineCommand::SetDetuneAmount:
+            wavetableSynth.setDetuneAmount(command.floatValue);
+            break;
+        case EngineCommand::SetSynthVolume:
+            wavetableSynth.setVolume(command.floatValue);
+            break;
+        case EngineCommand::SetSampleVolume:
+            sampler.setVolume(command.floatValue);
+            break;
+        case EngineCommand::SetWavetableBank:
+            commandQueue.retire(wavetableSynth.swapWavetableBank(static_cast<WavetableBank*>(command.object)));
+            break;
+        case EngineCommand::SetChorusRate:
+            chorusEffect->setRate(command.floatValue);
+            break;
+        case EngineCommand::SetReverbLevel: {
+            auto reverbParameters = reverbEffect->getParameters();
+            reverbParameters.wetLevel = command.floatValue;
+            reverbEffect->setParameters(reverbParameters);
+            break;
+        }
+        case EngineCommand::SetConvolver:
+            commandQueue.retire(convolutionEffect->swapConvolver(static_cast<PartitionedConvolver*>(command.object)));
+            break;
+        case EngineCommand::SetConvolutionWetLevel:
+            convolutionEffect->setWetLevel(command.floatValue);
+            break;
+        case EngineCommand::SetFilterMode:
+            wavetableSynth.setFilterMode(static_cast<SVFFilterBank::Mode>(command.intValue));
+            break;
+        case EngineCommand::SetGlobalLFO:
+            wavetableSynth.setGlobalLFO(static_cast<TableLFO::Shape>(command.intValue), command.floatValue);
+            break;
+        case EngineCommand::SetModulationRouting:
+            wavetableSynth.setModulationRouting(command.intValue & 0xff,
+                                                static_cast<ModulationMatrix::Source>((command.intValue >> 8) & 0xff),
+                                                static_cast<ModulationMatrix::Destination>((command.intValue >> 16) & 0xff),
+                                                command.floatValue);
+            break;
+    }
+}
+
+void NewProjectAudioProcessor::timerCallback() {
+    commandQueue.releaseRetired();
+    loadMonitor.update();
+
+    // An impulse response that finished loading across a sample rate change
+    // was turned away; build it again for the current rate
+    if (convolutionEffect->takeRebuildRequest()) {
+        backgroundJobs.addJob([this] {
+            if (auto convolver = convolutionEffect->rebuildConvolver()) {
+                commandQueue.push({ EngineCommand::SetConvolver, 0, 0.0f, convolver.get() });
+            }
+        });
+    }
+}
+
+// Unlike the setters above these don't go through commandQueue: each only
+// stores an atomic that the audio thread reads at the next note-on or
+// prepareToPlay, so they're safe to call from the message thread directly
+void NewProjectAudioProcessor::setPolyphony(int numVoices) {
+    wavetableSynth.setPolyphony(numVoices);
+}
+
+void NewProjectAudioProcessor::setNumRenderThreads(int numThreads) {
+    wavetableSynth.setNumRenderThreads(numThreads);
+}
+
+void NewProjectAudioProcessor::setVoiceStealingPolicy(VoiceAllocator::StealingPolicy policy) {
+    wavetableSynth.setStealingPolicy(policy);
 }
 
 // Ensure all parameters are retrieved safely.
@@ -188,69 +357,153 @@ void NewProjectAudioProcessor::setFilterResonance(float resonance) {
 }
 
 
-// Implementation
-void NewProjectAudioProcessor::triggerNoteOn(int noteNumber, float velocity) {
-    for (auto& voice : synthVoices) {
-        if (!voice.isActive()) {
-            voice.startNote(noteNumber, velocity); // Example parameters for attack and release
-            break;
+void NewProjectAudioProcessor::updateSynthVoiceADSR(float attack, float decay, float sustain, float release) {
+    // Goes through the parameters so the host sees the change and the audio
+    // thread picks it up with the next snapshot
+    const std::pair<const char*, float> values[] = {
+        { "attack", attack }, { "decay", decay }, { "sustain", sustain }, { "release", release }
+    };
+    for (const auto& [id, value] : values) {
+        if (auto* param = apvts.getParameter(id)) {
+            param->setValueNotifyingHost(param->convertTo0to1(value));
         }
     }
 }
 
+// Audio thread: pushes the block's snapshot to the engines. Smoothed values are
+// advanced by numSamples; the synth voices smooth cutoff and resonance themselves.
+void NewProjectAudioProcessor::applyParameters(int numSamples) {
+    wavetableSynth.setFilterParameters(parameters.filterCutoff, parameters.filterResonance);
+    wavetableSynth.setLFOParameters(parameters.lfoRate, parameters.lfoDepth);
 
-void NewProjectAudioProcessor::updateSynthVoiceADSR(float attack, float decay, float sustain, float release) {
-    // Loop through each voice and update ADSR settings
-    for (auto& voice : synthVoices) {  // Use reference to avoid pointer if not needed
-        voice.updateADSR(attack, decay, sustain, release);
+    sustainSmoother.setTargetValue(parameters.sustain);
+    const juce::ADSR::Parameters envelope { parameters.attack, parameters.decay,
+                                            sustainSmoother.skip(numSamples), parameters.release };
+    if (envelope.attack != appliedEnvelope.attack || envelope.decay != appliedEnvelope.decay
+        || envelope.sustain != appliedEnvelope.sustain || envelope.release != appliedEnvelope.release) {
+        wavetableSynth.setEnvelopeParameters(envelope);
+        appliedEnvelope = envelope;
     }
 }
 
 std::vector<juce::File> NewProjectAudioProcessor::getSampleFiles() const {
-    return sampleFiles;
+    const auto entries = sampleLibrary->getSnapshot();
+    std::vector<juce::File> files;
+    files.reserve(entries->size());
+    for (const auto& entry : *entries) {
+        files.push_back(entry.getFile());
+    }
+    return files;
 }
 
 // This function processes the audio block
 void NewProjectAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
-    auto* mixParam = apvts.getRawParameterValue("mix");
-    float mixLevel = mixParam ? mixParam->load() : 0.5f;
-
-    juce::AudioBuffer<float> synthBuffer(buffer.getNumChannels(), buffer.getNumSamples());
-    juce::AudioBuffer<float> sampleBuffer(buffer.getNumChannels(), buffer.getNumSamples());
-    synthBuffer.clear();
-    sampleBuffer.clear();
-
-    // Handle MIDI events
-    for (const auto midiMessage : midiMessages) {
-        const auto message = midiMessage.getMessage();
-        handleMidiEvent(message);
+    AllocationTripwire::ScopedAudioThreadGuard allocationGuard;  // No-op unless SYNTH_ALLOCATION_TRIPWIRE
+
+    const int numSamples = buffer.getNumSamples();
+    loadMonitor.beginBlock(numSamples);
+    commandQueue.drain([this](const EngineCommand& command) { applyCommand(command); });
+    parameterSource.read(parameters);
+
+    if (canSleep(buffer, midiMessages)) {
+        // Nothing can sound this block: skip every engine and effect, and leave
+        // the buffer flagged clear so the host can see the silence too
+        buffer.clear();
+        mixSmoother.setCurrentAndTargetValue(parameters.mix);
+        loadMonitor.endBlock(0);
+        return;
+    }
+    applyParameters(numSamples);
+    mixSmoother.setTargetValue(parameters.mix);
+
+    // Hosts may pass more samples than they announced in prepareToPlay. Rather
+    // than grow the scratch buffers here, render in chunks that fit them; each
+    // chunk is a view onto the host's buffer, which doesn't allocate.
+    const int chunkCapacity = synthScratchBuffer.getNumSamples();
+    jassert(chunkCapacity > 0 && buffer.getNumChannels() <= synthScratchBuffer.getNumChannels());
+    const int numChannels = juce::jmin(buffer.getNumChannels(), synthScratchBuffer.getNumChannels());
+
+    auto midiEvent = midiMessages.cbegin();
+    for (int chunkStart = 0; chunkCapacity > 0 && chunkStart < numSamples; chunkStart += chunkCapacity) {
+        const int chunkSize = juce::jmin(chunkCapacity, numSamples - chunkStart);
+        juce::AudioBuffer<float> chunk(buffer.getArrayOfWritePointers(), numChannels, chunkStart, chunkSize);
+        midiEvent = processChunk(chunk, midiEvent, midiMessages.cend(), chunkStart, chunkStart + chunkSize == numSamples);
     }
 
-    // Render audio
-    renderAudio(synthBuffer, sampleBuffer, buffer, mixLevel, midiMessages);
-
-    // Apply chorus
-    juce::dsp::AudioBlock<float> block(buffer);
-    chorus.process(juce::dsp::ProcessContextReplacing<float>(block));
+    loadMonitor.endBlock(wavetableSynth.getNumActiveVoices());
+}
+
+juce::MidiBufferIterator NewProjectAudioProcessor::processChunk(juce::AudioBuffer<float>& chunk, juce::MidiBufferIterator midiEvent,
+                                                                juce::MidiBufferIterator midiEnd, int chunkStart, bool isLastChunk) {
+    const int numSamples = chunk.getNumSamples();
+    auto& synthBuffer = synthScratchBuffer;
+    auto& samplerBuffer = samplerScratchBuffer;
+    synthBuffer.clear(0, numSamples);
+    samplerBuffer.clear(0, numSamples);
+
+    // Render up to each MIDI event, then dispatch it, so notes start on the sample
+    // the host scheduled them at rather than at the top of the block. Events
+    // beyond the block's end go at the end of the last chunk.
+    int position = 0;
+    for (; midiEvent != midiEnd; ++midiEvent) {
+        const auto metadata = *midiEvent;
+        if (!isLastChunk && metadata.samplePosition >= chunkStart + numSamples) break;
+
+        const int eventPosition = juce::jlimit(0, numSamples, metadata.samplePosition - chunkStart);
+        if (eventPosition > position) {
+            renderAudio(synthBuffer, samplerBuffer, position, eventPosition - position);
+            position = eventPosition;
+        }
+        DspLoadMonitor::ScopedStage stage(loadMonitor, DspLoadMonitor::MidiDispatch);
+        handleMidiEvent(metadata.getMessage());
+    }
+    if (position < numSamples) {
+        renderAudio(synthBuffer, samplerBuffer, position, numSamples - position);
+    }
 
-    // Apply reverb to each channel
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
-        float* channelData = buffer.getWritePointer(channel);
-        reverb.processStereo(channelData, channelData, buffer.getNumSamples());
+    // Mix down synth and sample buffers to the main buffer, ramping the balance
+    // across the chunk
+    {
+        DspLoadMonitor::ScopedStage stage(loadMonitor, DspLoadMonitor::Mix);
+        const float mixStart = mixSmoother.getCurrentValue();
+        const float mixEnd = mixSmoother.skip(numSamples);
+        for (int channel = 0; channel < chunk.getNumChannels(); ++channel) {
+            chunk.addFromWithRamp(channel, 0, synthBuffer.getReadPointer(channel), numSamples, mixStart, mixEnd);
+            chunk.addFromWithRamp(channel, 0, samplerBuffer.getReadPointer(channel), numSamples, 1.0f - mixStart, 1.0f - mixEnd);
+        }
     }
+
+    // Effects, each timed into its own stage; bypassed or sleeping slots are skipped
+    effects.process(chunk, numSamples, loadMonitor);
+    return midiEvent;
 }
 
 
-// This function renders audio
-void NewProjectAudioProcessor::renderAudio(juce::AudioBuffer<float>& synthBuffer, juce::AudioBuffer<float>& sampleBuffer, juce::AudioBuffer<float>& mainBuffer, float mixLevel, juce::MidiBuffer& midiMessages) {
-    // Render synthesizer and sampler buffers
-    wavetableSynth.renderNextBlock(synthBuffer, midiMessages, 0, mainBuffer.getNumSamples());
-    sampler.renderNextBlock(sampleBuffer, midiMessages, 0, mainBuffer.getNumSamples());
+// Idle when no MIDI arrives, no voice in either engine is sounding, the effects
+// have all gone to sleep and the input is silent. The first MIDI event wakes it.
+bool NewProjectAudioProcessor::canSleep(const juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages) const {
+    if (!midiMessages.isEmpty() || wavetableSynth.getNumActiveVoices() > 0
+        || sampler.getNumActiveVoices() > 0 || !effects.isIdle()) {
+        return false;
+    }
 
-    // Mix down synth and sample buffers to the main buffer
-    for (int channel = 0; channel < mainBuffer.getNumChannels(); ++channel) {
-        mainBuffer.addFrom(channel, 0, synthBuffer, channel, 0, mainBuffer.getNumSamples(), mixLevel);
-        mainBuffer.addFrom(channel, 0, sampleBuffer, channel, 0, mainBuffer.getNumSamples(), 1.0f - mixLevel);
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
+        if (!buffer.hasBeenCleared() && buffer.getMagnitude(channel, 0, buffer.getNumSamples()) > idleInputThreshold) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Renders both engines for one stretch of the block between MIDI events
+void NewProjectAudioProcessor::renderAudio(juce::AudioBuffer<float>& synthBuffer, juce::AudioBuffer<float>& sampleBuffer, int startSample, int numSamples) {
+    {
+        DspLoadMonitor::ScopedStage stage(loadMonitor, DspLoadMonitor::WavetableSynth);
+        wavetableSynth.renderNextBlock(synthBuffer, startSample, numSamples);
+    }
+    {
+        DspLoadMonitor::ScopedStage stage(loadMonitor, DspLoadMonitor::SamplePlayback);
+        sampler.renderNextBlock(sampleBuffer, startSample, numSamples);
     }
 }
 
@@ -275,34 +528,19 @@ void NewProjectAudioProcessor::handleMidiEvent(const juce::MidiMessage& message)
 void NewProjectAudioProcessor::scanSamplesDirectory(const juce::String& path) {
     juce::File directory(path);
     if (directory.exists() && directory.isDirectory()) {
-        // Initialize the ranged directory iterator to iterate through WAV files
-        juce::RangedDirectoryIterator iter(directory, true, "*.wav");
-
-        // Use a range-based for loop to process each file
-        for (auto& entry : iter) {
-            const auto& file = entry.getFile();  // Access the file from the DirectoryEntry object
-            if (file.existsAsFile()) { // Ensure the item is a file
-                sampleFiles.push_back(file); // Add the file to the list
-            }
-        }
+        // Incremental and asynchronous: only new or modified WAVs are opened, and
+        // getSampleFiles() keeps returning the previous listing until it's done
+        sampleLibrary->scan(directory);
     }
 }
 
 void NewProjectAudioProcessor::loadSample(const juce::String& path) {
     juce::File file(path);
     if (file.existsAsFile()) {
+        // The sampler decodes in the background through the shared sample pool;
+        // nothing here needs its own copy of the audio
         currentSampleFile = file;
-        juce::AudioFormatManager formatManager;
-        formatManager.registerBasicFormats();
-        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
-
-        if (reader) {
-            sampleBuffer.setSize(reader->numChannels, static_cast<int>(reader->lengthInSamples));
-            reader->read(&sampleBuffer, 0, static_cast<int>(reader->lengthInSamples), 0, true, true);
-            samplePosition = 0;
-        } else {
-            DBG("Failed to read sample");
-        }
+        sampler.loadSample(path);
     } else {
         DBG("File does not exist: " + path);
     }
@@ -3,11 +3,17 @@
 #include <JuceHeader.h>
 #include "WavetableSynthesizer.h"
 #include "Sampler.h"
+#include "SampleLibraryIndex.h"
+#include "ParameterSnapshot.h"
+#include "EngineCommandQueue.h"
+#include "DspLoadMonitor.h"
+#include "EffectsChain.h"
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
 
 
-class NewProjectAudioProcessor : public juce::AudioProcessor {
+class NewProjectAudioProcessor : public juce::AudioProcessor,
+                                 private juce::Timer {
 public:
     NewProjectAudioProcessor();
     ~NewProjectAudioProcessor() override;
@@ -16,7 +22,12 @@ public:
     void releaseResources() override;
     void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
     void handleMidiEvent(const juce::MidiMessage& message);
-    void renderAudio(juce::AudioBuffer<float>& synthBuffer, juce::AudioBuffer<float>& sampleBuffer, juce::AudioBuffer<float>& mainBuffer, float mixLevel, juce::MidiBuffer& midiMessages);
+    void renderAudio(juce::AudioBuffer<float>& synthBuffer, juce::AudioBuffer<float>& sampleBuffer, int startSample, int numSamples);
+    // Renders and mixes one stretch of processBlock that fits the scratch
+    // buffers, dispatching the MIDI events inside it; returns the first event
+    // left for the next stretch
+    juce::MidiBufferIterator processChunk(juce::AudioBuffer<float>& chunk, juce::MidiBufferIterator midiEvent,
+                                          juce::MidiBufferIterator midiEnd, int chunkStart, bool isLastChunk);
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
 
@@ -36,8 +47,6 @@ public:
     void getStateInformation(juce::MemoryBlock& destData) override;
     void setStateInformation(const void* data, int sizeInBytes) override;
 
-    void triggerNoteOn( int midiNoteNumber, float velocity);  // Make sure the parameters match.
-   
     float getParameterValue(const juce::String& paramId) const {
         return *apvts.getRawParameterValue(paramId);
     }
@@ -63,27 +72,81 @@ public:
     void setSampleVolume(float volume);
     void setUnisonSize(int size);
     void setDetuneAmount(float amount);
+    void setPolyphony(int numVoices);
+    void setNumRenderThreads(int numThreads);
+    void setVoiceStealingPolicy(VoiceAllocator::StealingPolicy policy);
+    // Replaces the synth's wavetables at the next block; the old bank is
+    // released back on the message thread
+    void setWavetableBank(WavetableBank::Ptr bank);
     void setFilterCutoff(float cutoff);
     void setFilterResonance(float resonance);
+    void setFilterMode(SVFFilterBank::Mode mode);
     void setLFORate(float rate);
     void setLFODepth(float depth);
+    // Modulation beyond the LFO-to-cutoff that the parameters drive; an amount of
+    // zero removes a routing. Slot 0 is taken by the LFO depth parameter.
+    void setModulationRouting(int slot, ModulationMatrix::Source source,
+                              ModulationMatrix::Destination destination, float amount);
+    void setGlobalLFO(TableLFO::Shape shape, float rateHz);
     float volume;
-    juce::Reverb reverb;
-    juce::dsp::Chorus<float> chorus;
+
+    // Effects run in slot order on the mixed output: chorus, reverb, then
+    // convolution reverb
+    void setChorusRate(float rateHz);
+    void setReverbLevel(float wetLevel);
+    // Loads an impulse response in the background, by name from the SAMPLES
+    // directory or by absolute path, and swaps it in once it's ready
+    void loadImpulseResponse(const juce::String& fileName);
+    void setConvolutionWetLevel(float wetLevel);
+    // True bypass: a bypassed slot costs nothing
+    void setEffectBypassed(int slotIndex, bool shouldBypass);
 
     std::vector<juce::File> getSampleFiles() const;
+    // Per-stage processBlock timing; poll getLatestSummary() from any thread
+    DspLoadMonitor& getLoadMonitor() { return loadMonitor; }
+
+    // Shared index of the SAMPLES directory; listen to it for updates
+    SampleLibraryIndex& getSampleLibrary() { return *sampleLibrary; }
 
 private:
+    // Engine setters called from the message thread are queued here and applied
+    // at the start of the next block
+    EngineCommandQueue commandQueue;
+    void applyCommand(const EngineCommand& command);
+    void timerCallback() override;  // Releases whatever the audio thread handed back and publishes DSP load
+
+    DspLoadMonitor loadMonitor;
+
+    EffectsChain effects;
+    ChorusEffect* chorusEffect = nullptr;  // Owned by effects
+    ReverbEffect* reverbEffect = nullptr;
+    ConvolutionReverbEffect* convolutionEffect = nullptr;
+
     WavetableSynthesizer wavetableSynth;
     Sampler sampler;
     juce::AudioProcessorValueTreeState apvts;
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-    SynthVoice mySynthVoice;
-    std::vector<SynthVoice> synthVoices;
-    juce::AudioBuffer<float> sampleBuffer;
-    std::vector<juce::File> sampleFiles;
+    // Parameters reach the engines through a snapshot taken at the top of each
+    // block; the atomics behind it are looked up once, here
+    ParameterSnapshotSource parameterSource { apvts };
+    ParameterSnapshot parameters;
+    juce::SmoothedValue<float> mixSmoother;
+    juce::SmoothedValue<float> sustainSmoother;  // The ADSR would jump to a new level otherwise
+    juce::ADSR::Parameters appliedEnvelope;
+    static constexpr double parameterSmoothingSecs = 0.05;
+    void applyParameters(int numSamples);
+
+    bool canSleep(const juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midiMessages) const;
+    static constexpr float idleInputThreshold = 1.0e-5f;  // Matches the effects' silence threshold
+    // Per-engine scratch for processBlock, sized in prepareToPlay so the audio
+    // callback never allocates
+    juce::AudioBuffer<float> synthScratchBuffer;
+    juce::AudioBuffer<float> samplerScratchBuffer;
+    juce::SharedResourcePointer<SampleLibraryIndex> sampleLibrary;
     juce::File currentSampleFile;
-    int samplePosition = 0;
+
+    // Impulse response loading; declared last so jobs finish before anything they use goes
+    juce::ThreadPool backgroundJobs { 1 };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NewProjectAudioProcessor)
 };
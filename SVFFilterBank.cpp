@@ -0,0 +1,171 @@
+#include "SVFFilterBank.h"
+
+SVFFilterBank::SVFFilterBank(int numFilters)
+    : g(static_cast<size_t>(numFilters), 0.0f), gStep(g.size(), 0.0f),
+      k(g.size(), 1.0f), kStep(g.size(), 0.0f),
+      ic1(g.size(), 0.0f), ic2(g.size(), 0.0f),
+      rampRemaining(g.size(), 0), snapToTarget(g.size(), 1) {}
+
+void SVFFilterBank::prepare(double newSampleRate) {
+    sampleRate = newSampleRate;
+    for (int filter = 0; filter < getNumFilters(); ++filter) {
+        reset(filter);
+    }
+}
+
+void SVFFilterBank::reset(int filter) {
+    const auto i = static_cast<size_t>(filter);
+    ic1[i] = ic2[i] = 0.0f;
+    gStep[i] = kStep[i] = 0.0f;
+    rampRemaining[i] = 0;
+    snapToTarget[i] = 1;
+}
+
+void SVFFilterBank::setTarget(int filter, float cutoff, float resonance, int rampLengthInSamples) {
+    const auto i = static_cast<size_t>(filter);
+    const double nyquistLimit = 0.49 * sampleRate;
+    const auto targetG = static_cast<float>(std::tan(juce::MathConstants<double>::pi
+                                                     * juce::jlimit(20.0, nyquistLimit, static_cast<double>(cutoff)) / sampleRate));
+    const float targetK = 1.0f / juce::jmax(0.1f, resonance);
+
+    if (snapToTarget[i] || rampLengthInSamples <= 1) {
+        g[i] = targetG;
+        k[i] = targetK;
+        gStep[i] = kStep[i] = 0.0f;
+        rampRemaining[i] = 0;
+        snapToTarget[i] = 0;
+        return;
+    }
+
+    const float ramp = static_cast<float>(rampLengthInSamples);
+    gStep[i] = (targetG - g[i]) / ramp;
+    kStep[i] = (targetK - k[i]) / ramp;
+    rampRemaining[i] = rampLengthInSamples;
+}
+
+void SVFFilterBank::process(const int* filters, int numFilters, float* io, int numSamples) {
+    jassert(numFilters > 0 && numFilters <= laneCount);
+    jassert(reinterpret_cast<std::uintptr_t>(io) % 64 == 0);
+    juce::ScopedNoDenormals noDenormals;  // Decaying integrator states would otherwise crawl
+
+    // Output = high * v0 + (band - high * k) * v1 + (low - high) * v2, which picks
+    // one response without a branch in the loop
+    const float low = mode == LowPass ? 1.0f : 0.0f;
+    const float band = mode == BandPass ? 1.0f : 0.0f;
+    const float high = mode == HighPass ? 1.0f : 0.0f;
+
+    // Lanes without a filter run a harmless idle one
+    alignas(64) float laneG[laneCount], laneGStep[laneCount], laneK[laneCount], laneKStep[laneCount];
+    alignas(64) float laneIc1[laneCount], laneIc2[laneCount];
+    int laneRamp[laneCount];
+    for (int lane = 0; lane < laneCount; ++lane) {
+        const bool used = lane < numFilters;
+        const auto i = used ? static_cast<size_t>(filters[lane]) : 0;
+        laneG[lane] = used ? g[i] : 0.0f;
+        laneK[lane] = used ? k[i] : 1.0f;
+        laneIc1[lane] = used ? ic1[i] : 0.0f;
+        laneIc2[lane] = used ? ic2[i] : 0.0f;
+        laneRamp[lane] = used ? rampRemaining[i] : 0;
+        laneGStep[lane] = used ? gStep[i] : 0.0f;
+        laneKStep[lane] = used ? kStep[i] : 0.0f;
+    }
+
+    // Coefficients for a stretch, one row of lanes per sample like io
+    alignas(64) float gRows[maxStretch * laneCount], kRows[maxStretch * laneCount], a1Rows[maxStretch * laneCount];
+
+    int done = 0;
+    while (done < numSamples) {
+        // Split where the first ramp ends, so every lane either glides or holds
+        // for the whole stretch
+        int length = juce::jmin(numSamples - done, maxStretch);
+        for (int lane = 0; lane < laneCount; ++lane) {
+            if (laneRamp[lane] > 0) length = juce::jmin(length, laneRamp[lane]);
+        }
+
+        // a1 = 1 / (1 + g(g + k)) exactly, however far g and k move per sample
+        for (int lane = 0; lane < laneCount; ++lane) {
+            const bool gliding = laneRamp[lane] > 0;
+            const float gStepL = gliding ? laneGStep[lane] : 0.0f;
+            const float kStepL = gliding ? laneKStep[lane] : 0.0f;
+            float gL = laneG[lane], kL = laneK[lane];
+            for (int sample = 0; sample < length; ++sample) {
+                gRows[sample * laneCount + lane] = gL;
+                kRows[sample * laneCount + lane] = kL;
+                gL += gStepL;
+                kL += kStepL;
+            }
+            laneG[lane] = gL;
+            laneK[lane] = kL;
+        }
+        for (int i = 0; i < length * laneCount; ++i) {
+            a1Rows[i] = 1.0f / (1.0f + gRows[i] * (gRows[i] + kRows[i]));
+        }
+        float* rows = io + done * laneCount;
+
+#if JUCE_USE_SIMD
+        using FloatVec = juce::dsp::SIMDRegister<float>;
+        const auto two = FloatVec::expand(2.0f);
+        const auto highV = FloatVec::expand(high);
+        const auto bandV = FloatVec::expand(band);
+        const auto lowMinusHigh = FloatVec::expand(low - high);
+        auto s1 = FloatVec::fromRawArray(laneIc1), s2 = FloatVec::fromRawArray(laneIc2);
+
+        for (int sample = 0; sample < length; ++sample) {
+            const int row = sample * laneCount;
+            const auto gV = FloatVec::fromRawArray(gRows + row);
+            const auto kV = FloatVec::fromRawArray(kRows + row);
+            const auto a1 = FloatVec::fromRawArray(a1Rows + row);
+            const auto a2 = gV * a1;
+            const auto a3 = gV * a2;
+
+            const auto v0 = FloatVec::fromRawArray(rows + row);
+            const auto v3 = v0 - s2;
+            const auto v1 = a1 * s1 + a2 * v3;
+            const auto v2 = s2 + a2 * s1 + a3 * v3;
+            s1 = two * v1 - s1;
+            s2 = two * v2 - s2;
+
+            const auto output = highV * v0 + (bandV - highV * kV) * v1 + lowMinusHigh * v2;
+            output.copyToRawArray(rows + row);
+        }
+
+        s1.copyToRawArray(laneIc1);
+        s2.copyToRawArray(laneIc2);
+#else
+        for (int lane = 0; lane < laneCount; ++lane) {
+            float s1 = laneIc1[lane], s2 = laneIc2[lane];
+            for (int sample = 0; sample < length; ++sample) {
+                const int index = sample * laneCount + lane;
+                const float gL = gRows[index], kL = kRows[index];
+                const float a1 = a1Rows[index];
+                const float a2 = gL * a1;
+                const float a3 = gL * a2;
+
+                float& x = rows[index];
+                const float v3 = x - s2;
+                const float v1 = a1 * s1 + a2 * v3;
+                const float v2 = s2 + a2 * s1 + a3 * v3;
+                s1 = 2.0f * v1 - s1;
+                s2 = 2.0f * v2 - s2;
+                x = high * x + (band - high * kL) * v1 + (low - high) * v2;
+            }
+            laneIc1[lane] = s1;
+            laneIc2[lane] = s2;
+        }
+#endif
+
+        for (int lane = 0; lane < laneCount; ++lane) {
+            laneRamp[lane] = juce::jmax(0, laneRamp[lane] - length);
+        }
+        done += length;
+    }
+
+    for (int lane = 0; lane < numFilters; ++lane) {
+        const auto i = static_cast<size_t>(filters[lane]);
+        g[i] = laneG[lane];
+        k[i] = laneK[lane];
+        ic1[i] = laneIc1[lane];
+        ic2[i] = laneIc2[lane];
+        rampRemaining[i] = laneRamp[lane];
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+// Topology-preserving state-variable filters for a whole voice pool, one per
+// voice, run several at a time in SIMD lanes. State and coefficients live in
+// per-filter arrays; process() gathers up to laneCount filters into registers,
+// runs them side by side over an interleaved block and scatters them back.
+//
+// Cutoff and resonance glide linearly in g and k between control-rate targets.
+// Every sample's coefficients are worked out exactly before the filters run;
+// SIMDRegister has no divide, so that's a plain loop the compiler vectorises.
+class SVFFilterBank {
+public:
+    enum Mode { LowPass, BandPass, HighPass, NumModes };
+
+#if JUCE_USE_SIMD
+    static constexpr int laneCount = static_cast<int>(juce::dsp::SIMDRegister<float>::SIMDNumElements);
+#else
+    static constexpr int laneCount = 4;
+#endif
+
+    explicit SVFFilterBank(int numFilters);
+
+    // Clears every filter; the next target for each is taken immediately
+    void prepare(double newSampleRate);
+    void reset(int filter);
+
+    // Shared by every filter in the bank
+    void setMode(Mode newMode) { mode = newMode; }
+    Mode getMode() const { return mode; }
+
+    // Starts a linear glide to the given cutoff (Hz) and resonance (Q), reaching
+    // it after rampLengthInSamples. The first call after a reset jumps there.
+    void setTarget(int filter, float cutoff, float resonance, int rampLengthInSamples);
+
+    // Runs numFilters (up to laneCount) filters over io in place. io holds
+    // numSamples rows of laneCount floats, lane i belonging to filters[i]; it
+    // must be aligned to 64 bytes. Lanes past numFilters are processed but ignored.
+    void process(const int* filters, int numFilters, float* io, int numSamples);
+
+    int getNumFilters() const { return static_cast<int>(g.size()); }
+
+private:
+    static constexpr int maxStretch = 64;  // Samples of coefficients worked out at a time
+
+    double sampleRate = 48000.0;
+    Mode mode = LowPass;
+
+    // One entry per filter
+    std::vector<float> g, gStep;   // Integrator gain, tan(pi * fc / fs)
+    std::vector<float> k, kStep;   // Damping, 1 / Q
+    std::vector<float> ic1, ic2;   // Integrator states
+    std::vector<int> rampRemaining;
+    std::vector<char> snapToTarget;
+};
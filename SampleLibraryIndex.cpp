@@ -0,0 +1,221 @@
+#include "SampleLibraryIndex.h"
+
+SampleLibraryIndex::SampleLibraryIndex()
+    : juce::Thread("Sample library index"),
+      snapshot(std::make_shared<const std::vector<Entry>>()) {
+    formatManager.registerBasicFormats();
+    startThread(juce::Thread::Priority::low);
+}
+
+SampleLibraryIndex::~SampleLibraryIndex() {
+    stopThread(4000);
+}
+
+juce::File SampleLibraryIndex::getDefaultDirectory() {
+    juce::File appDataDir = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory);
+    juce::File sampleDir = appDataDir.getChildFile("NewProject/SAMPLES");
+    if (!sampleDir.exists()) {
+        sampleDir.createDirectory();
+    }
+    return sampleDir;
+}
+
+void SampleLibraryIndex::scan(const juce::File& directory) {
+    {
+        const juce::ScopedLock sl(lock);
+        requestedDirectory = directory;
+    }
+    notify();
+}
+
+SampleLibraryIndex::Snapshot SampleLibraryIndex::getSnapshot() const {
+    const juce::ScopedLock sl(lock);
+    return snapshot;
+}
+
+bool SampleLibraryIndex::findEntry(const juce::File& file, Entry& result) const {
+    const auto entries = getSnapshot();
+    const auto& path = file.getFullPathName();
+    auto it = std::lower_bound(entries->begin(), entries->end(), path,
+                               [](const Entry& entry, const juce::String& p) { return entry.path < p; });
+    if (it == entries->end() || it->path != path) return false;
+
+    result = *it;
+    return true;
+}
+
+void SampleLibraryIndex::run() {
+    while (!threadShouldExit()) {
+        juce::File directory;
+        {
+            const juce::ScopedLock sl(lock);
+            directory = requestedDirectory;
+            requestedDirectory = juce::File();
+        }
+
+        if (directory != juce::File()) {
+            scanning.store(true);
+            updateIndex(directory);
+            scanning.store(false);
+        } else {
+            wait(-1);
+        }
+    }
+}
+
+void SampleLibraryIndex::updateIndex(const juce::File& directory) {
+    if (!directory.isDirectory()) return;
+
+    // Start from what we know: the live entries if this directory is already
+    // indexed, otherwise whatever was saved last time. Publishing the saved
+    // index straight away gives the browser something to show during the walk.
+    std::vector<Entry> known;
+    if (directory == indexedDirectory) {
+        known = *getSnapshot();
+    } else if (loadIndexFile(directory, known)) {
+        indexedDirectory = directory;
+        publish(known);
+    }
+
+    auto findKnown = [&known](const juce::String& path) -> const Entry* {
+        auto it = std::lower_bound(known.begin(), known.end(), path,
+                                   [](const Entry& entry, const juce::String& p) { return entry.path < p; });
+        return it != known.end() && it->path == path ? &*it : nullptr;
+    };
+
+    std::vector<Entry> updated;
+    updated.reserve(known.size());
+    bool changed = false;
+
+    // The directory walk already provides size and modification time, so an
+    // unchanged file is never opened
+    for (const auto& dirEntry : juce::RangedDirectoryIterator(directory, true, "*.wav", juce::File::findFiles)) {
+        if (threadShouldExit()) return;
+
+        Entry entry;
+        entry.path = dirEntry.getFile().getFullPathName();
+        entry.fileSize = dirEntry.getFileSize();
+        entry.modificationTime = dirEntry.getModificationTime().toMilliseconds();
+
+        if (auto* previous = findKnown(entry.path);
+            previous != nullptr && previous->fileSize == entry.fileSize && previous->modificationTime == entry.modificationTime) {
+            updated.push_back(*previous);
+        } else if (readEntry(dirEntry.getFile(), entry)) {
+            updated.push_back(entry);
+            changed = true;
+        }
+    }
+
+    std::sort(updated.begin(), updated.end(), [](const Entry& a, const Entry& b) { return a.path < b.path; });
+    changed = changed || updated.size() != known.size();  // Catches deleted files
+
+    if (changed || directory != indexedDirectory) {
+        saveIndexFile(directory, updated);
+    }
+    indexedDirectory = directory;
+    publish(std::move(updated));
+}
+
+bool SampleLibraryIndex::readEntry(const juce::File& file, Entry& entry) {
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr) {
+        DBG("Skipping unreadable sample: " << file.getFullPathName());
+        return false;
+    }
+
+    entry.numChannels = static_cast<int>(reader->numChannels);
+    entry.sampleRate = reader->sampleRate;
+    entry.lengthInSamples = reader->lengthInSamples;
+
+    std::vector<juce::Range<float>> levels(static_cast<size_t>(juce::jmax(1, entry.numChannels)));
+    reader->readMaxLevels(0, reader->lengthInSamples, levels.data(), entry.numChannels);
+    entry.peak = 0.0f;
+    for (int channel = 0; channel < entry.numChannels; ++channel) {
+        const auto& range = levels[static_cast<size_t>(channel)];
+        entry.peak = juce::jmax(entry.peak, std::abs(range.getStart()), std::abs(range.getEnd()));
+    }
+    return true;
+}
+
+void SampleLibraryIndex::publish(std::vector<Entry> entries) {
+    auto newSnapshot = std::make_shared<const std::vector<Entry>>(std::move(entries));
+    {
+        const juce::ScopedLock sl(lock);
+        snapshot = std::move(newSnapshot);
+    }
+    sendChangeMessage();
+}
+
+juce::File SampleLibraryIndex::getIndexFileFor(const juce::File& directory) {
+    return directory.getSiblingFile(directory.getFileName() + ".index");
+}
+
+bool SampleLibraryIndex::loadIndexFile(const juce::File& directory, std::vector<Entry>& entries) const {
+    juce::FileInputStream in(getIndexFileFor(directory));
+    if (!in.openedOk()) return false;
+
+    if (in.readInt() != indexFileMagic || in.readInt() != indexFileVersion) {
+        DBG("Ignoring sample index in an unknown format");
+        return false;
+    }
+    if (in.readString() != directory.getFullPathName()) return false;  // Index of another directory
+
+    const int numEntries = in.readInt();
+    if (numEntries < 0) return false;
+
+    entries.clear();
+    entries.reserve(static_cast<size_t>(numEntries));
+    for (int i = 0; i < numEntries && !in.isExhausted(); ++i) {
+        Entry entry;
+        entry.path = in.readString();
+        entry.fileSize = in.readInt64();
+        entry.modificationTime = in.readInt64();
+        entry.numChannels = in.readInt();
+        entry.sampleRate = in.readDouble();
+        entry.lengthInSamples = in.readInt64();
+        entry.peak = in.readFloat();
+        entries.push_back(entry);
+    }
+
+    if (static_cast<int>(entries.size()) != numEntries) {
+        DBG("Sample index is truncated; rebuilding it");
+        entries.clear();
+        return false;
+    }
+
+    // Saved sorted, but don't rely on it for the binary searches
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.path < b.path; });
+    return true;
+}
+
+void SampleLibraryIndex::saveIndexFile(const juce::File& directory, const std::vector<Entry>& entries) const {
+    // Write to a temporary file first so a crash never leaves a half-written index
+    juce::TemporaryFile temp(getIndexFileFor(directory));
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (!out.openedOk()) {
+            DBG("Couldn't write sample index: " << out.getStatus().getErrorMessage());
+            return;
+        }
+
+        out.writeInt(indexFileMagic);
+        out.writeInt(indexFileVersion);
+        out.writeString(directory.getFullPathName());
+        out.writeInt(static_cast<int>(entries.size()));
+        for (const auto& entry : entries) {
+            out.writeString(entry.path);
+            out.writeInt64(entry.fileSize);
+            out.writeInt64(entry.modificationTime);
+            out.writeInt(entry.numChannels);
+            out.writeDouble(entry.sampleRate);
+            out.writeInt64(entry.lengthInSamples);
+            out.writeFloat(entry.peak);
+        }
+        out.flush();
+        if (out.getStatus().failed()) {
+            DBG("Couldn't write sample index: " << out.getStatus().getErrorMessage());
+            return;
+        }
+    }
+    temp.overwriteTargetFileWithTemporary();
+}
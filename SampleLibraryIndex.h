@@ -0,0 +1,72 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include <vector>
+
+// Persistent index of the WAV files under the SAMPLES directory. The index is
+// kept in a small binary file next to the directory and brought up to date on
+// a background thread: only files that are new or whose size or modification
+// time changed are opened, so rescanning a large, mostly unchanged library is
+// little more than a directory walk. One index is shared by every plugin
+// instance in the process through juce::SharedResourcePointer.
+class SampleLibraryIndex : public juce::ChangeBroadcaster,
+                           private juce::Thread {
+public:
+    struct Entry {
+        juce::String path;
+        juce::int64 fileSize = 0;
+        juce::int64 modificationTime = 0;  // Milliseconds since the epoch
+        int numChannels = 0;
+        double sampleRate = 0.0;
+        juce::int64 lengthInSamples = 0;
+        float peak = 0.0f;  // Absolute peak over all channels
+
+        juce::File getFile() const { return juce::File(path); }
+    };
+
+    // Entries sorted by path. A snapshot never changes once published, so it can
+    // be held and searched freely while the index updates.
+    using Snapshot = std::shared_ptr<const std::vector<Entry>>;
+
+    SampleLibraryIndex();
+    ~SampleLibraryIndex() override;
+
+    // Points the index at a directory and starts an incremental rescan of it.
+    // Listeners get a change message once the updated entries are published.
+    void scan(const juce::File& directory);
+
+    Snapshot getSnapshot() const;
+
+    // Binary search by path; returns false if the file isn't indexed (yet)
+    bool findEntry(const juce::File& file, Entry& result) const;
+
+    bool isScanning() const { return scanning.load(); }
+
+    // Where the plugin keeps its samples, created on first use
+    static juce::File getDefaultDirectory();
+
+private:
+    void run() override;
+    void updateIndex(const juce::File& directory);
+    bool readEntry(const juce::File& file, Entry& entry);
+
+    bool loadIndexFile(const juce::File& directory, std::vector<Entry>& entries) const;
+    void saveIndexFile(const juce::File& directory, const std::vector<Entry>& entries) const;
+    static juce::File getIndexFileFor(const juce::File& directory);
+
+    void publish(std::vector<Entry> entries);
+
+    juce::AudioFormatManager formatManager;
+
+    mutable juce::CriticalSection lock;  // Guards snapshot and requestedDirectory
+    Snapshot snapshot;
+    juce::File requestedDirectory;
+    juce::File indexedDirectory;  // Background thread only
+    std::atomic<bool> scanning { false };
+
+    static constexpr int indexFileMagic = 0x58494c53;  // "SLIX"
+    static constexpr int indexFileVersion = 1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleLibraryIndex)
+};
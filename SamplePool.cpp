@@ -0,0 +1,99 @@
+#include "SamplePool.h"
+
+SamplePool::SamplePool() {
+    formatManager.registerBasicFormats();
+}
+
+juce::String SamplePool::makeKey(const juce::File& file) {
+    return file.getFullPathName() + "|" + juce::String(file.getSize()) + "|"
+         + juce::String(file.getLastModificationTime().toMilliseconds());
+}
+
+bool SamplePool::holdsEnough(const PooledSample& sample, double maxLengthSecs) {
+    return sample.getNumSamples() >= sample.getSourceLengthInSamples()
+        || sample.getNumSamples() >= static_cast<juce::int64>(maxLengthSecs * sample.getSampleRate());
+}
+
+PooledSample::Ptr SamplePool::getSample(const juce::File& file, double maxLengthSecs) {
+    const auto key = makeKey(file);
+    {
+        const juce::ScopedLock sl(lock);
+        const int index = keys.indexOf(key);
+        if (index >= 0 && holdsEnough(*samples[index], maxLengthSecs)) return samples[index];
+    }
+
+    // Load without holding the lock so other instances' cache hits aren't held up
+    auto sample = load(file, maxLengthSecs);
+    if (sample == nullptr) return nullptr;
+
+    const juce::ScopedLock sl(lock);
+    const int index = keys.indexOf(key);
+    if (index >= 0) {
+        if (holdsEnough(*samples[index], maxLengthSecs)) return samples[index];  // Someone else loaded it meanwhile
+
+        // The entry was too short for this request; the longer load takes its
+        // place, and whoever holds the short one keeps it until they let go
+        samples.set(index, sample);
+    } else {
+        keys.add(key);
+        samples.add(sample);
+    }
+    releaseUnused();
+    return sample;
+}
+
+void SamplePool::releaseUnused() {
+    const juce::ScopedLock sl(lock);
+    for (int i = samples.size(); --i >= 0;) {
+        if (samples.getObjectPointerUnchecked(i)->getReferenceCount() == 1) {
+            samples.remove(i);
+            keys.remove(i);
+        }
+    }
+}
+
+PooledSample::Ptr SamplePool::load(const juce::File& file, double maxLengthSecs) {
+    PooledSample::Ptr sample = new PooledSample();
+
+    // Uncompressed WAVs: map the part we keep instead of decoding it. Like a
+    // decoded file it stops at maxLengthSecs, so a streamed sound only shares
+    // its head and SampleStreamer reads the rest.
+    if (file.hasFileExtension("wav")) {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(wavFormat.createMemoryMappedReader(file));
+        const auto numToMap = mapped != nullptr
+            ? juce::jmin(static_cast<juce::int64>(maxLengthSecs * mapped->sampleRate), mapped->lengthInSamples)
+            : juce::int64 { 0 };
+        if (mapped != nullptr && mapped->numChannels <= PooledSample::maxChannels && numToMap > 0
+            && mapped->mapSectionOfFile({ 0, numToMap })) {
+            // Fault the mapped pages in now so the first note doesn't have to
+            const int bytesPerFrame = static_cast<int>(mapped->numChannels) * juce::jmax(1, mapped->bitsPerSample / 8);
+            const juce::int64 samplesPerPage = juce::jmax(1, 4096 / bytesPerFrame);
+            for (juce::int64 i = 0; i < numToMap; i += samplesPerPage) {
+                mapped->touchSample(i);
+            }
+
+            sample->numChannels = static_cast<int>(mapped->numChannels);
+            sample->numSamples = numToMap;
+            sample->sourceLengthInSamples = mapped->lengthInSamples;
+            sample->sampleRate = mapped->sampleRate;
+            sample->mappedReader = std::move(mapped);
+            return sample;
+        }
+    }
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr) {
+        DBG("Failed to load sample from path: " << file.getFullPathName());
+        return nullptr;
+    }
+
+    const auto maxSamples = static_cast<juce::int64>(maxLengthSecs * reader->sampleRate);
+    const int numToRead = static_cast<int>(juce::jmin(maxSamples, reader->lengthInSamples));
+    sample->numChannels = juce::jmin(PooledSample::maxChannels, static_cast<int>(reader->numChannels));
+    sample->decoded.setSize(sample->numChannels, numToRead);
+    reader->read(&sample->decoded, 0, numToRead, 0, true, true);
+    sample->numSamples = numToRead;
+    sample->sourceLengthInSamples = reader->lengthInSamples;
+    sample->sampleRate = reader->sampleRate;
+    return sample;
+}
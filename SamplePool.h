@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Audio data for one file, shared by every sound and plugin instance that
+// uses it. Uncompressed WAVs are memory-mapped rather than decoded, so the OS
+// can share the file's pages; everything else is decoded into a float buffer
+// once. Either way only the first maxLengthSecs are held.
+class PooledSample : public juce::ReferenceCountedObject {
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<PooledSample>;
+
+    static constexpr int maxChannels = 2;
+
+    int getNumChannels() const { return numChannels; }
+    juce::int64 getNumSamples() const { return numSamples; }  // Frames available in memory
+    juce::int64 getSourceLengthInSamples() const { return sourceLengthInSamples; }  // Frames in the file
+    double getSampleRate() const { return sampleRate; }
+    bool isMemoryMapped() const { return mappedReader != nullptr; }
+
+    // Fills frame[0..1] with the frame at index < getNumSamples(). A mono file
+    // fills both. Doesn't allocate or lock, so it's safe on the audio thread.
+    void getFrame(juce::int64 index, float* frame) const {
+        if (mappedReader != nullptr) {
+            mappedReader->getSample(index, frame);
+        } else {
+            for (int channel = 0; channel < numChannels; ++channel) {
+                frame[channel] = decoded.getSample(channel, static_cast<int>(index));
+            }
+        }
+        if (numChannels == 1) frame[1] = frame[0];
+    }
+
+private:
+    friend class SamplePool;
+    PooledSample() = default;
+
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mappedReader;
+    juce::AudioBuffer<float> decoded;
+    int numChannels = 0;
+    juce::int64 numSamples = 0;
+    juce::int64 sourceLengthInSamples = 0;
+    double sampleRate = 0.0;
+
+    JUCE_LEAK_DETECTOR(PooledSample)
+};
+
+// Process-wide cache of PooledSamples keyed by file identity (path, size and
+// modification time), so thirty instances loading the same kit hold one copy.
+// There's one entry per file whatever length was asked for: a shorter request
+// shares a longer entry, and a longer one replaces it.
+// Hold it through juce::SharedResourcePointer<SamplePool>.
+class SamplePool {
+public:
+    SamplePool();
+
+    // Returns the shared data for file, loading it if no-one holds it yet.
+    // Holds at least maxLengthSecs (or the whole file, if shorter) and may hold
+    // more when a longer load of the same file is already shared.
+    // Blocks while decoding, so call it from a loader thread. Returns nullptr if
+    // the file can't be read.
+    PooledSample::Ptr getSample(const juce::File& file, double maxLengthSecs);
+
+    // Drops entries only the pool still refers to; called by getSample too
+    void releaseUnused();
+
+private:
+    PooledSample::Ptr load(const juce::File& file, double maxLengthSecs);
+    static juce::String makeKey(const juce::File& file);
+    static bool holdsEnough(const PooledSample& sample, double maxLengthSecs);
+
+    juce::AudioFormatManager formatManager;
+    juce::WavAudioFormat wavFormat;
+
+    juce::CriticalSection lock;  // Guards keys and samples
+    juce::StringArray keys;
+    juce::ReferenceCountedArray<PooledSample> samples;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SamplePool)
+};
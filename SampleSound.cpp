@@ -0,0 +1,25 @@
+#include "SampleSound.h"
+
+SampleSound::SampleSound(const juce::String& soundName,
+                         PooledSample::Ptr data,
+                         const juce::File& sourceFile,
+                         const juce::BigInteger& notes,
+                         int midiNoteForNormalPitch,
+                         double attackTimeSecs,
+                         double releaseTimeSecs,
+                         bool streamFromDisk)
+    : name(soundName), file(sourceFile), preloadedData(std::move(data)),
+      midiNotes(notes), midiRootNote(midiNoteForNormalPitch) {
+    jassert(preloadedData != nullptr);
+
+    // Anything that fits in the head is simply held in memory
+    streamed = streamFromDisk && preloadedData->getSourceLengthInSamples() > preloadedData->getNumSamples();
+    lengthInSamples = streamed ? preloadedData->getSourceLengthInSamples() : preloadedData->getNumSamples();
+
+    envelopeParameters.attack = static_cast<float>(attackTimeSecs);
+    envelopeParameters.release = static_cast<float>(releaseTimeSecs);
+}
+
+std::unique_ptr<juce::AudioFormatReader> SampleSound::createStreamReader(juce::AudioFormatManager& formatManager) const {
+    return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(file));
+}
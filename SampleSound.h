@@ -0,0 +1,53 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SamplePool.h"
+
+// Sample mapped onto a range of notes. Its audio lives in a PooledSample shared
+// with every other sound using the same file. Short samples are held in full;
+// streamed ones only have a head in memory and leave the rest on disk for
+// SampleStreamer to fetch while a voice plays, so their length isn't capped.
+class SampleSound : public juce::SynthesiserSound {
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<SampleSound>;
+
+    // With streamFromDisk set, whatever of the file isn't in data is read from
+    // sourceFile during playback; otherwise the sound ends where data does.
+    SampleSound(const juce::String& soundName,
+                PooledSample::Ptr data,
+                const juce::File& sourceFile,
+                const juce::BigInteger& notes,
+                int midiNoteForNormalPitch,
+                double attackTimeSecs,
+                double releaseTimeSecs,
+                bool streamFromDisk);
+
+    bool appliesToNote(int midiNoteNumber) override { return midiNotes[midiNoteNumber]; }
+    bool appliesToChannel(int midiChannel) override { return true; }
+
+    const juce::String& getName() const { return name; }
+    const juce::File& getFile() const { return file; }
+    const PooledSample& getPreloadedData() const { return *preloadedData; }
+    juce::int64 getNumPreloadedSamples() const { return preloadedData->getNumSamples(); }
+    juce::int64 getLengthInSamples() const { return lengthInSamples; }
+    int getNumChannels() const { return preloadedData->getNumChannels(); }
+    double getSourceSampleRate() const { return preloadedData->getSampleRate(); }
+    int getMidiRootNote() const { return midiRootNote; }
+    const juce::ADSR::Parameters& getEnvelopeParameters() const { return envelopeParameters; }
+    bool isStreamed() const { return streamed; }
+
+    // Opens a fresh reader on the source file for streaming; background thread only
+    std::unique_ptr<juce::AudioFormatReader> createStreamReader(juce::AudioFormatManager& formatManager) const;
+
+private:
+    juce::String name;
+    juce::File file;
+    PooledSample::Ptr preloadedData;
+    juce::int64 lengthInSamples = 0;  // Playable length, preloaded head included
+    juce::BigInteger midiNotes;
+    int midiRootNote = 60;
+    juce::ADSR::Parameters envelopeParameters;
+    bool streamed = false;
+
+    JUCE_LEAK_DETECTOR(SampleSound)
+};
@@ -0,0 +1,14 @@
+#include "SampleSoundSet.h"
+
+SampleSound* SampleSoundSet::getSoundForNote(int midiNoteNumber) const {
+    for (auto* sound : sounds) {
+        if (sound->appliesToNote(midiNoteNumber)) {
+            return sound;
+        }
+    }
+    return nullptr;
+}
+
+bool SampleSoundSlot::appliesToNote(int midiNoteNumber) {
+    return soundSet != nullptr && soundSet->getSoundForNote(midiNoteNumber) != nullptr;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleSound.h"
+
+// The sounds the sampler plays, published to the audio thread as one unit.
+// A set is built on the loader thread and never changes once published, so
+// the audio thread can read it without locking.
+class SampleSoundSet : public juce::ReferenceCountedObject {
+public:
+    void addSound(SampleSound::Ptr sound) { sounds.add(sound); }
+
+    // First sound mapped to the note, or nullptr
+    SampleSound* getSoundForNote(int midiNoteNumber) const;
+
+    int getNumSounds() const { return sounds.size(); }
+
+private:
+    juce::ReferenceCountedArray<SampleSound> sounds;
+
+    JUCE_LEAK_DETECTOR(SampleSoundSet)
+};
+
+// The only sound ever registered with the sampler's Synthesiser. It stands in
+// for whichever SampleSoundSet is current, so swapping samples never touches
+// the Synthesiser's sound list. Only the audio thread changes or reads the set.
+class SampleSoundSlot : public juce::SynthesiserSound {
+public:
+    void setSoundSet(const SampleSoundSet* newSet) { soundSet = newSet; }
+    const SampleSoundSet* getSoundSet() const { return soundSet; }
+
+    bool appliesToNote(int midiNoteNumber) override;
+    bool appliesToChannel(int midiChannel) override { return true; }
+
+private:
+    const SampleSoundSet* soundSet = nullptr;
+};
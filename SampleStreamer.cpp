@@ -0,0 +1,115 @@
+#include "SampleStreamer.h"
+
+SampleStreamer::Stream::Stream(int ringSizeInSamples)
+    : fifo(ringSizeInSamples), ring(2, ringSizeInSamples) {
+    ring.clear();
+}
+
+void SampleStreamer::Stream::request(SampleSound* sound) {
+    requestedSound.store(sound, std::memory_order_relaxed);
+    requestGeneration.fetch_add(1, std::memory_order_release);
+}
+
+SampleStreamer::SampleStreamer()
+    : juce::Thread("Sample streamer") {
+    formatManager.registerBasicFormats();
+}
+
+SampleStreamer::~SampleStreamer() {
+    stopThread(2000);
+    releasePendingObjects();
+}
+
+SampleStreamer::Stream* SampleStreamer::createStream(int ringSizeInSamples) {
+    jassert(!isThreadRunning());
+    streams.push_back(std::make_unique<Stream>(ringSizeInSamples));
+    return streams.back().get();
+}
+
+int SampleStreamer::getTotalUnderruns() const {
+    int total = 0;
+    for (auto& stream : streams) {
+        total += stream->getNumUnderruns();
+    }
+    return total;
+}
+
+bool SampleStreamer::releaseLater(juce::ReferenceCountedObject* object) {
+    if (releaseFifo.getFreeSpace() == 0) return false;
+
+    const auto scope = releaseFifo.write(1);
+    pendingReleases[static_cast<size_t>(scope.startIndex1)] = object;
+    return true;
+}
+
+void SampleStreamer::releasePendingObjects() {
+    const auto scope = releaseFifo.read(releaseFifo.getNumReady());
+    scope.forEach([this](int index) {
+        pendingReleases[static_cast<size_t>(index)]->decReferenceCount();
+    });
+}
+
+void SampleStreamer::run() {
+    while (!threadShouldExit()) {
+        // Requests made before an object was queued have all been superseded by
+        // now, so no stream can pick up a pointer to it after this
+        releasePendingObjects();
+
+        bool didWork = false;
+        for (auto& stream : streams) {
+            didWork = service(*stream) || didWork;
+        }
+
+        // Rings hold well over a hundred milliseconds, so a short nap is safe
+        if (!didWork) {
+            wait(2);
+        }
+    }
+}
+
+bool SampleStreamer::service(Stream& stream) {
+    const uint32_t generation = stream.requestGeneration.load(std::memory_order_acquire);
+
+    if (generation != stream.servicedGeneration) {
+        // New request: the voice isn't reading the ring until readyGeneration
+        // matches, so it is safe to reset it from this side
+        stream.servicedGeneration = generation;
+        stream.fifo.reset();
+
+        SampleSound* sound = stream.requestedSound.load(std::memory_order_relaxed);
+        if (sound != nullptr && sound->isStreamed()) {
+            if (sound != stream.readerSound.get() || stream.reader == nullptr) {
+                stream.reader = sound->createStreamReader(formatManager);
+                stream.readerSound = sound;
+            }
+            stream.nextSampleToRead = sound->getNumPreloadedSamples();
+            stream.endOfSound = sound->getLengthInSamples();
+            fill(stream);
+        } else {
+            stream.endOfSound = 0;
+        }
+
+        stream.readyGeneration.store(generation, std::memory_order_release);
+        return true;
+    }
+
+    return fill(stream);
+}
+
+bool SampleStreamer::fill(Stream& stream) {
+    if (stream.reader == nullptr || stream.nextSampleToRead >= stream.endOfSound) return false;
+
+    const int remaining = static_cast<int>(juce::jmin(static_cast<juce::int64>(readChunkSize), stream.endOfSound - stream.nextSampleToRead));
+    const int numToRead = juce::jmin(remaining, stream.fifo.getFreeSpace());
+    if (numToRead <= 0) return false;
+
+    const auto scope = stream.fifo.write(numToRead);
+    if (scope.blockSize1 > 0) {
+        stream.reader->read(&stream.ring, scope.startIndex1, scope.blockSize1, stream.nextSampleToRead, true, true);
+    }
+    if (scope.blockSize2 > 0) {
+        stream.reader->read(&stream.ring, scope.startIndex2, scope.blockSize2, stream.nextSampleToRead + scope.blockSize1, true, true);
+    }
+    stream.nextSampleToRead += numToRead;
+    return true;
+}
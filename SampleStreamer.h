@@ -0,0 +1,81 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleSound.h"
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Background disk reader for streamed SampleSounds. Every sampler voice owns a
+// Stream: a lock-free ring buffer the streamer keeps topped up with the part
+// of the sample that follows the preloaded head. The audio thread never opens
+// or reads a file; when the ring runs dry the voice plays silence and counts
+// an underrun instead of waiting.
+class SampleStreamer : public juce::Thread {
+public:
+    class Stream {
+    public:
+        explicit Stream(int ringSizeInSamples);
+
+        // Audio thread: start streaming sound from the end of its preloaded head,
+        // or stop (nullptr). Earlier ring contents are discarded by the streamer.
+        void request(SampleSound* sound);
+
+        // Audio thread: true once the ring holds data for the latest request
+        bool isReady() const { return readyGeneration.load(std::memory_order_acquire) == requestGeneration.load(std::memory_order_relaxed); }
+
+        juce::AbstractFifo& getFifo() { return fifo; }
+        const juce::AudioBuffer<float>& getRing() const { return ring; }
+
+        void addUnderrun() { underruns.fetch_add(1, std::memory_order_relaxed); }
+        int getNumUnderruns() const { return underruns.load(std::memory_order_relaxed); }
+
+    private:
+        friend class SampleStreamer;
+
+        juce::AbstractFifo fifo;
+        juce::AudioBuffer<float> ring;
+
+        std::atomic<SampleSound*> requestedSound { nullptr };
+        std::atomic<uint32_t> requestGeneration { 0 };
+        std::atomic<uint32_t> readyGeneration { 0 };
+        std::atomic<int> underruns { 0 };
+
+        // Streamer thread only
+        uint32_t servicedGeneration = 0;
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        SampleSound::Ptr readerSound;  // Keeps the sound alive while its reader is open
+        juce::int64 nextSampleToRead = 0;
+        juce::int64 endOfSound = 0;
+    };
+
+    SampleStreamer();
+    ~SampleStreamer() override;
+
+    // Creates a stream owned by the streamer. Call before the thread starts.
+    Stream* createStream(int ringSizeInSamples);
+
+    int getTotalUnderruns() const;
+
+    // Audio thread: hands over one reference to object, which the streamer drops
+    // between passes. Anything a voice may have requested must be released this
+    // way so it is never deleted while a request for it is being serviced.
+    // Returns false if the queue is full; try again on a later block.
+    bool releaseLater(juce::ReferenceCountedObject* object);
+
+    void run() override;
+
+private:
+    bool service(Stream& stream);
+    bool fill(Stream& stream);
+    void releasePendingObjects();
+
+    juce::AudioFormatManager formatManager;
+    std::vector<std::unique_ptr<Stream>> streams;
+
+    static constexpr int maxPendingReleases = 16;
+    juce::AbstractFifo releaseFifo { maxPendingReleases };
+    std::array<juce::ReferenceCountedObject*, maxPendingReleases> pendingReleases {};
+
+    static constexpr int readChunkSize = 8192;  // Samples per disk read
+};
@@ -0,0 +1,126 @@
+#include "SampleVoice.h"
+
+SampleVoice::SampleVoice(SampleStreamer::Stream& streamToUse)
+    : stream(streamToUse) {}
+
+bool SampleVoice::canPlaySound(juce::SynthesiserSound* sound) {
+    return dynamic_cast<const SampleSoundSlot*>(sound) != nullptr;
+}
+
+void SampleVoice::startNote(int midiNoteNumber, float velocity, juce::SynthesiserSound* sound, int) {
+    // The slot only claims notes its set covers, but it may have been given a
+    // new set since then
+    playingSet = static_cast<const SampleSoundSlot*>(sound)->getSoundSet();
+    playingSound = playingSet != nullptr ? playingSet->getSoundForNote(midiNoteNumber) : nullptr;
+    if (playingSound == nullptr) {
+        playingSet = nullptr;
+        clearCurrentNote();
+        return;
+    }
+
+    pitchRatio = std::pow(2.0, (midiNoteNumber - playingSound->getMidiRootNote()) / 12.0)
+                 * playingSound->getSourceSampleRate() / getSampleRate();
+    sourcePosition = 0.0;
+    gain = velocity;
+
+    ringStartIndex = playingSound->getNumPreloadedSamples();
+    stream.request(playingSound->isStreamed() ? const_cast<SampleSound*>(playingSound) : nullptr);
+
+    adsr.setSampleRate(getSampleRate());
+    adsr.setParameters(playingSound->getEnvelopeParameters());
+    adsr.noteOn();
+}
+
+void SampleVoice::stopNote(float, bool allowTailOff) {
+    if (allowTailOff) {
+        adsr.noteOff();
+    } else {
+        finishNote();
+    }
+}
+
+void SampleVoice::finishNote() {
+    if (playingSound != nullptr && playingSound->isStreamed()) {
+        stream.request(nullptr);
+    }
+    playingSound = nullptr;
+    playingSet = nullptr;
+    adsr.reset();
+    clearCurrentNote();
+}
+
+bool SampleVoice::getSourceFrame(juce::int64 index, float* frame) const {
+    const auto& head = playingSound->getPreloadedData();
+    if (index < head.getNumSamples()) {
+        head.getFrame(index, frame);
+        return true;
+    }
+
+    const juce::int64 offset = index - ringStartIndex;
+    if (offset < 0 || offset >= ringSize1 + ringSize2) return false;
+
+    // The streamer duplicates mono files into both ring channels
+    const int ringIndex = offset < ringSize1 ? ringStart1 + static_cast<int>(offset)
+                                             : ringStart2 + static_cast<int>(offset - ringSize1);
+    frame[0] = stream.getRing().getSample(0, ringIndex);
+    frame[1] = stream.getRing().getSample(1, ringIndex);
+    return true;
+}
+
+void SampleVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) {
+    if (playingSound == nullptr) return;
+
+    // Snapshot what the streamer has delivered so far; it only ever appends
+    ringSize1 = ringSize2 = 0;
+    const bool streaming = playingSound->isStreamed() && stream.isReady();
+    if (streaming) {
+        auto& fifo = stream.getFifo();
+        fifo.prepareToRead(fifo.getNumReady(), ringStart1, ringSize1, ringStart2, ringSize2);
+    }
+
+    const juce::int64 length = playingSound->getLengthInSamples();
+    const int numOutputChannels = juce::jmin(2, outputBuffer.getNumChannels());
+    bool underrun = false;
+
+    for (int i = 0; i < numSamples; ++i) {
+        const auto index = static_cast<juce::int64>(sourcePosition);
+        if (index + 1 >= length) {
+            finishNote();
+            break;
+        }
+
+        const float alpha = static_cast<float>(sourcePosition - static_cast<double>(index));
+        const float envelope = adsr.getNextSample() * gain;
+
+        float current[2], next[2];
+        if (getSourceFrame(index, current) && getSourceFrame(index + 1, next)) {
+            for (int channel = 0; channel < numOutputChannels; ++channel) {
+                outputBuffer.addSample(channel, startSample + i, (current[channel] + alpha * (next[channel] - current[channel])) * envelope);
+            }
+        } else {
+            underrun = true;
+        }
+
+        sourcePosition += pitchRatio;
+
+        if (!adsr.isActive()) {
+            finishNote();
+            break;
+        }
+    }
+
+    if (underrun) {
+        stream.addUnderrun();
+    }
+
+    // Hand back the ring space for everything behind the read position
+    if (streaming) {
+        const juce::int64 consumed = juce::jlimit(static_cast<juce::int64>(0),
+                                                  static_cast<juce::int64>(ringSize1 + ringSize2),
+                                                  static_cast<juce::int64>(sourcePosition) - ringStartIndex);
+        if (consumed > 0 && playingSound != nullptr) {
+            stream.getFifo().finishedRead(static_cast<int>(consumed));
+            ringStartIndex += consumed;
+        }
+    }
+}
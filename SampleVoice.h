@@ -0,0 +1,47 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleSound.h"
+#include "SampleSoundSet.h"
+#include "SampleStreamer.h"
+
+// Plays a SampleSound with linear interpolation for pitch. Samples come from
+// the sound's preloaded head and, for streamed sounds, continue from this
+// voice's SampleStreamer ring once the head has been used up. The voice is
+// started on the sampler's SampleSoundSlot and plays from the set current at
+// note-on until the note ends, even if a new set is published meanwhile.
+class SampleVoice : public juce::SynthesiserVoice {
+public:
+    explicit SampleVoice(SampleStreamer::Stream& streamToUse);
+
+    bool canPlaySound(juce::SynthesiserSound* sound) override;
+    void startNote(int midiNoteNumber, float velocity, juce::SynthesiserSound* sound, int currentPitchWheelPosition) override;
+    void stopNote(float velocity, bool allowTailOff) override;
+    void pitchWheelMoved(int newValue) override {}
+    void controllerMoved(int controllerNumber, int newValue) override {}
+    void renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override;
+
+    // Set the playing note was taken from, or nullptr when silent
+    const SampleSoundSet* getPlayingSet() const { return playingSet; }
+
+private:
+    // Stereo source frame at index, from the head or the stream ring. Returns
+    // false if the stream hasn't delivered that far yet.
+    bool getSourceFrame(juce::int64 index, float* frame) const;
+    void finishNote();
+
+    SampleStreamer::Stream& stream;
+    const SampleSoundSet* playingSet = nullptr;
+    const SampleSound* playingSound = nullptr;
+
+    double sourcePosition = 0.0;
+    double pitchRatio = 1.0;
+    float gain = 0.0f;
+    juce::ADSR adsr;
+
+    // Per-block view of the ring, taken once in renderNextBlock
+    juce::int64 ringStartIndex = 0;  // Source index of the oldest sample in the ring
+    int ringStart1 = 0, ringSize1 = 0, ringStart2 = 0, ringSize2 = 0;
+
+    JUCE_LEAK_DETECTOR(SampleVoice)
+};
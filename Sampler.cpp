@@ -1,47 +1,125 @@
 #include "Sampler.h"
+#include "SampleVoice.h"
 
 Sampler::Sampler() {
-    formatManager.registerBasicFormats();  // Register supported audio formats
+    for (int i = 0; i < numVoices; ++i) {
+        sampleVoices[static_cast<size_t>(i)] = new SampleVoice(*streamer.createStream(streamRingSize));
+        synth.addVoice(sampleVoices[static_cast<size_t>(i)]);
+    }
+
+    // The slot is the synth's one and only sound; loading a sample never adds more
+    soundSlot = new SampleSoundSlot();
+    synth.addSound(soundSlot);
+
+    streamer.startThread();
 }
 
 Sampler::~Sampler() {
-    // Resources are automatically cleaned up by unique_ptr and other JUCE-managed objects
+    // Finish any load in progress, then stop disk reads before the voices and
+    // sounds they refer to go away
+    loaderPool.removeAllJobs(true, 5000);
+    streamer.stopThread(2000);
+
+    if (auto* unusedSet = pendingSet.exchange(nullptr)) {
+        unusedSet->decReferenceCount();
+    }
+    if (activeSet != nullptr) {
+        activeSet->decReferenceCount();
+    }
+    for (int i = 0; i < numDrainingSets; ++i) {
+        drainingSets[static_cast<size_t>(i)]->decReferenceCount();
+    }
 }
 
 void Sampler::prepareToPlay(double sampleRate, int samplesPerBlock) {
     synth.setCurrentPlaybackSampleRate(sampleRate);
-    midiCollector.reset(sampleRate);
     DBG("Sampler prepared with Sample Rate: " << sampleRate << ", Samples Per Block: " << samplesPerBlock);
 }
 
 
 void Sampler::loadSample(const juce::String& path) {
-    juce::File file(path);
-    if (!file.existsAsFile()) {
-        DBG("File does not exist: " << path);
-        return;
-    }
-    formatReader.reset(formatManager.createReaderFor(file));
-    if (formatReader) {
+    const bool alwaysStream = diskStreaming.load();
+
+    loaderPool.addJob([this, path, alwaysStream] {
+        juce::File file(path);
+        if (!file.existsAsFile()) {
+            DBG("File does not exist: " << path);
+            return;
+        }
+        const bool streamFromDisk = alwaysStream || file.getSize() > streamingThresholdBytes;
+
+        // Another instance may already have this file in memory
+        auto data = samplePool->getSample(file, streamFromDisk ? streamPreloadSecs : maxSampleLengthSecs);
+        if (data == nullptr) return;
+
         juce::BigInteger midiNotes;
         midiNotes.setRange(0, 128, true);
-        auto* sound = new juce::SamplerSound("SampleSound", *formatReader, midiNotes, 60, 0, 0.1, 10);
-        synth.addSound(sound);
-    } else {
-        DBG("Failed to load sample from path: " << path);
+
+        auto* newSet = new SampleSoundSet();
+        newSet->addSound(new SampleSound("SampleSound", data, file, midiNotes, 60, 0.0, 0.1, streamFromDisk));
+        publishSoundSet(newSet);
+    });
+}
+
+void Sampler::publishSoundSet(SampleSoundSet* newSet) {
+    newSet->incReferenceCount();
+    // A set that was published but never picked up was never seen by a voice,
+    // so it can go straight away
+    if (auto* unusedSet = pendingSet.exchange(newSet)) {
+        unusedSet->decReferenceCount();
     }
 }
 
-std::atomic<float> volume;  // Declare volume as std::atomic to ensure thread-safe modification
+void Sampler::adoptPendingSet() {
+    // Only swap while there is room to keep the old set draining; otherwise keep
+    // playing the current one and try again next block
+    if (pendingSet.load() == nullptr || numDrainingSets == maxDrainingSets) return;
 
+    auto* incoming = pendingSet.exchange(nullptr);
+    if (incoming == nullptr) return;
+
+    if (activeSet != nullptr) {
+        drainingSets[static_cast<size_t>(numDrainingSets++)] = activeSet;
+    }
+    activeSet = incoming;
+    soundSlot->setSoundSet(activeSet);
+}
+
+void Sampler::retireFinishedSets() {
+    for (int i = numDrainingSets - 1; i >= 0; --i) {
+        auto* set = drainingSets[static_cast<size_t>(i)];
+        if (!isSetInUse(set) && streamer.releaseLater(set)) {
+            drainingSets[static_cast<size_t>(i)] = drainingSets[static_cast<size_t>(--numDrainingSets)];
+        }
+    }
+}
+
+int Sampler::getNumActiveVoices() const {
+    int numActive = 0;
+    for (auto* voice : sampleVoices) {
+        if (voice->isVoiceActive()) ++numActive;
+    }
+    return numActive;
+}
+
+bool Sampler::isSetInUse(const SampleSoundSet* set) const {
+    for (auto* voice : sampleVoices) {
+        if (voice->getPlayingSet() == set) return true;
+    }
+    return false;
+}
 
 // Or for atomic
 void Sampler::setVolume(float newVolume) {
-    volume.store(std::clamp(newVolume, 0.0f, 1.0f));
-    DBG("Volume set to: " << volume.load());
+    volume.store(std::clamp(newVolume, 0.0f, 1.0f));  // Called on the audio thread, so no logging
+}
+
+void Sampler::setDiskStreaming(bool shouldStream) {
+    diskStreaming.store(shouldStream);
 }
 
 void Sampler::handleNoteOn(int midiNoteNumber, float velocity) {
+    adoptPendingSet();  // A note-on should hear the newest sample
     synth.noteOn(1, midiNoteNumber, velocity);
 }
 
@@ -49,13 +127,14 @@ void Sampler::handleNoteOff(int midiNoteNumber, float velocity) {
     synth.noteOff(1, midiNoteNumber, velocity, true);
 }
 
-void Sampler::renderNextBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int startSample, int numSamples) {
-    midiCollector.removeNextBlockOfMessages(midiMessages, numSamples);
-    synth.renderNextBlock(buffer, midiMessages, startSample, numSamples);
+void Sampler::renderNextBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) {
+    adoptPendingSet();
+    synth.renderNextBlock(buffer, noMidi, startSample, numSamples);
+    retireFinishedSets();
     buffer.applyGainRamp(startSample, numSamples, volume, volume);
 }
 
 void Sampler::releaseResources() {
+    // The loaded sample stays in place; it's freed with the sampler
     DBG("Releasing Sampler resources.");
-    synth.clearSounds();  // Assuming you want to clear all sounds
 }
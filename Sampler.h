@@ -1,8 +1,14 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "SampleStreamer.h"
+#include "SampleSoundSet.h"
+#include "SamplePool.h"
+#include <array>
 #include <atomic>
 
+class SampleVoice;
+
 class Sampler {
 public:
     Sampler();
@@ -10,16 +16,61 @@ public:
 
     void prepareToPlay(double sampleRate, int samplesPerBlock);
     void releaseResources();
+    // Queues the file for decoding on the loader thread and returns straight
+    // away. Once ready it replaces the current sample; notes already playing
+    // finish on the old one.
     void loadSample(const juce::String& path);
     void setVolume(float newVolume);
     void handleNoteOn(int midiNoteNumber, float velocity);
     void handleNoteOff(int midiNoteNumber, float velocity);
-    void renderNextBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int startSample, int numSamples);
+    // Adds numSamples of the sampler into buffer from startSample on. Notes arrive
+    // through handleNoteOn/handleNoteOff between calls, never through MIDI here.
+    void renderNextBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+    // Samples whose file is over streamingThresholdBytes keep only their first
+    // second in memory and stream the rest from disk. Turning this on streams
+    // every sample loaded from now on, whatever its size. Off by default.
+    void setDiskStreaming(bool shouldStream);
+    // Blocks in which a voice ran out of streamed data, summed over all voices
+    int getNumStreamUnderruns() const { return streamer.getTotalUnderruns(); }
+
+    // Voices currently playing or releasing; audio thread
+    int getNumActiveVoices() const;
+
+    static constexpr int numVoices = 16;
 
 private:
+    // Declared before synth so the voices' streams outlive them
+    SampleStreamer streamer;
     juce::Synthesiser synth;
-    juce::MidiMessageCollector midiCollector;
-    std::unique_ptr<juce::AudioFormatReader> formatReader;
-    juce::AudioFormatManager formatManager;
+    juce::MidiBuffer noMidi;  // Always empty; notes are dispatched directly to synth
+    juce::SharedResourcePointer<SamplePool> samplePool;  // Decoded files shared across instances
     std::atomic<float> volume{1.0f};  // Initialize volume to default
+    std::atomic<bool> diskStreaming{false};
+
+    // Sound set hand-over. The loader thread publishes through pendingSet; the
+    // audio thread adopts it at the start of a block and keeps the set it
+    // replaces in drainingSets until no voice plays from it, then passes it to
+    // the streamer to be freed. Each pointer here owns one reference.
+    SampleSoundSlot* soundSlot = nullptr;  // Owned by synth
+    std::atomic<SampleSoundSet*> pendingSet { nullptr };
+    SampleSoundSet* activeSet = nullptr;
+    static constexpr int maxDrainingSets = 8;
+    std::array<SampleSoundSet*, maxDrainingSets> drainingSets {};
+    int numDrainingSets = 0;
+    std::array<SampleVoice*, numVoices> sampleVoices {};  // Owned by synth
+
+    void publishSoundSet(SampleSoundSet* newSet);
+    void adoptPendingSet();
+    void retireFinishedSets();
+    bool isSetInUse(const SampleSoundSet* set) const;
+
+    juce::ThreadPool loaderPool { 1 };  // Decodes samples; declared last so it stops first
+
+    static constexpr int streamRingSize = 32768;     // Per-voice ring, about 0.7 s at 48 kHz
+    static constexpr double streamPreloadSecs = 1.0;  // Head kept in memory for streamed sounds
+    static constexpr double maxSampleLengthSecs = 10.0;  // Cap for fully loaded sounds
+    // Files over this run past maxSampleLengthSecs even as 16-bit stereo at
+    // 48 kHz, so they're streamed rather than cut short
+    static constexpr juce::int64 streamingThresholdBytes = 2 * 1024 * 1024;
 };
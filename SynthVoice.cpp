@@ -2,51 +2,60 @@
 #include <JuceHeader.h>
 
 SynthVoice::SynthVoice()
-    : active(false), frequency(440.0f), midiNoteNumber(-1),
-      currentSampleIndex(0.0), increment(0.0), velocity(0.0),
-      amplitude(1.0), currentWaveform(0), unisonSize(1), detuneAmount(0.0f),
-filter(), lfoPhase(0.0f), lfoRate(0.1f), lfoDepth(10.0f),
-baseCutoffFrequency(2000.0f) {  // Initialize filter object directly
-
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = 48000.0;
-    spec.maximumBlockSize = 512;
-    spec.numChannels = 1;
-
-    filter.prepare(spec);
-    updateFilter();  // Use the correct function name
-
-    initializeWavetable();
+    : active(false), frequency(440.0f), midiNoteNumber(-1), velocity(0.0),
+      amplitude(1.0), envelopeLevel(&ownEnvelopeLevel), currentWaveform(0), mipLevel(0), wavetable(nullptr),
+filterControlInterval(32), samplesUntilFilterUpdate(0),
+baseCutoffFrequency(2000.0f), resonance(1.0f), sampleRate(48000.0f) {  // Initialize filter object directly
+
+    cutoffSmoother.setCurrentAndTargetValue(baseCutoffFrequency);
+    resonanceSmoother.setCurrentAndTargetValue(resonance);
+    lfo.setRate(5.0f);
+    updateModulation();
 }
 
-void SynthVoice::initializeWavetable() {
-    // Correct initialization for wavetable array
-    for (auto& table : wavetable) {
-        table.assign(wavetableSize, 0.0f);  // Assign zeroes initially or use a loop to fill with sin values
-        for (size_t i = 0; i < wavetableSize; ++i) {
-            table[i] = std::sin(2.0 * M_PI * i / wavetableSize);
-        }
+void SynthVoice::setWavetable(const WavetableBank* newWavetable) {
+    wavetable = newWavetable;
+    if (wavetable != nullptr) {
+        currentWaveform = std::min(currentWaveform, wavetable->getNumWaveforms() - 1);
     }
 }
 
-void SynthVoice::setWavetable(const std::array<std::vector<float>, 4>& newWavetable) {
-    wavetable = newWavetable;
+void SynthVoice::setWaveform(int waveformIndex) {
+    const int numWaveforms = wavetable != nullptr ? wavetable->getNumWaveforms() : 1;
+    currentWaveform = juce::jlimit(0, numWaveforms - 1, waveformIndex);
+}
+
+void SynthVoice::updateMipLevel() {
+    mipLevel = WavetableBank::getMipLevelForIncrement(oscillator.getMaxIncrement());
 }
 
 void SynthVoice::startNote(int midiNoteNumber, float velocity) {
     this->midiNoteNumber = midiNoteNumber;
     this->velocity = velocity;
-    
-    // Assuming `attack` and `release` are class members initialized properly
-    // If not, you might need to define them as parameters or fixed values
-    float attack = 0.5f;  // Example value for attack
-    float release = 0.5f;  // Example value for release
-
-    // Set ADSR parameters
-    adsr.setParameters({attack, 0.1f, 0.8f, release}); // Fixed decay of 0.1 and sustain of 0.8
-
-    adsr.noteOn();
+    frequency = midiNoteToFrequency(midiNoteNumber);
+    pitchOffset = 0.0f;
+    oscillator.setFrequency(frequency / getSampleRate());
+    oscillator.resetPhases();
+    updateMipLevel();
+
+    // Idle voices don't advance their smoothers, so start from the current targets
+    cutoffSmoother.setCurrentAndTargetValue(cutoffSmoother.getTargetValue());
+    resonanceSmoother.setCurrentAndTargetValue(resonanceSmoother.getTargetValue());
+
+    // A restarted or stolen voice mustn't carry the last note's filter energy;
+    // the coefficients jump straight to the new note's at updateModulation
+    jassert(filterBank != nullptr);  // Set by setFilter or prepareToPlay
+    filterBank->reset(filterIndex);
+
+    // Envelope times come from updateADSR
+    envelope.noteOn();
     active = true;
+
+    // Modulation for the new note applies from its first sample, without a ramp
+    samplesSinceUpdate = 0;
+    updateModulation();
+    volumeLevel += volumeStep * static_cast<float>(filterControlInterval);
+    volumeStep = 0.0f;
 }
 
 
@@ -55,10 +64,11 @@ void SynthVoice::startNote(int midiNoteNumber, float velocity) {
 
 void SynthVoice::stopNote(bool allowTailOff) {
     if (allowTailOff) {
-        // Implement note release logic
+        envelope.noteOff();  // The voice frees itself once the release stage has finished
     } else {
         this->active = false;
-        adsr.reset();
+        envelope.reset();
+        *envelopeLevel = 0.0f;
     }
 }
 
@@ -66,15 +76,84 @@ int SynthVoice::getNoteNumber() const {
     return midiNoteNumber;
 }
 
-void SynthVoice::updateFilter() {
-    float modulatedCutoff = baseCutoffFrequency + std::sin(lfoPhase) * lfoDepth;
-    modulatedCutoff = std::clamp(modulatedCutoff, 20.0f, 20000.0f);
-    auto coeffs = juce::dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), modulatedCutoff, 1.0f);
-    filter.coefficients = *coeffs;
-    lfoPhase += lfoRate * (1.0f / getSampleRate());
-    if (lfoPhase > 2.0 * M_PI) {
-        lfoPhase -= 2.0 * M_PI;
+// Called once per control interval: evaluates the modulation matrix and sets the
+// cutoff and gain to reach by the next update. The smoothers and LFO catch up
+// with the samples rendered since the last update, which is less than a whole
+// interval when alignControlUpdates brought it forward.
+void SynthVoice::updateModulation() {
+    const float cutoff = cutoffSmoother.skip(samplesSinceUpdate);
+    const float q = resonanceSmoother.skip(samplesSinceUpdate);
+
+    float offsets[ModulationMatrix::NumDestinations] = {};
+    if (modulationMatrix != nullptr && modulationMatrix->getNumActiveRoutings() > 0) {
+        float sources[ModulationMatrix::NumSources];
+        sources[ModulationMatrix::GlobalLFO] = globalLFO != nullptr ? *globalLFO : 0.0f;
+        sources[ModulationMatrix::VoiceLFO] = modulationMatrix->usesSource(ModulationMatrix::VoiceLFO) ? lfo.getValue() : 0.0f;
+        sources[ModulationMatrix::Envelope] = envelope.getCurrentLevel();
+        sources[ModulationMatrix::Velocity] = velocity;
+        sources[ModulationMatrix::Note] = (midiNoteNumber - 60) / 60.0f;  // Roughly -1..1 across the keyboard
+        modulationMatrix->process(sources, offsets);
+    }
+    lfo.advance(samplesSinceUpdate);
+    samplesSinceUpdate = 0;
+
+    const float modulatedCutoff = std::clamp(cutoff * std::exp2(offsets[ModulationMatrix::Cutoff]), 20.0f, 20000.0f);
+    if (filterBank != nullptr) {
+        filterBank->setTarget(filterIndex, modulatedCutoff, q, filterControlInterval);
     }
+
+    // Pitch and detune retune the oscillator, so only when they've moved
+    if (offsets[ModulationMatrix::Pitch] != pitchOffset) {
+        pitchOffset = offsets[ModulationMatrix::Pitch];
+        oscillator.setFrequency(frequency * std::exp2(pitchOffset / 12.0f) / getSampleRate());
+        updateMipLevel();
+    }
+    if (offsets[ModulationMatrix::Detune] != detuneOffset) {
+        detuneOffset = offsets[ModulationMatrix::Detune];
+        oscillator.setDetune(juce::jmax(0.0f, detuneAmount + detuneOffset));
+        updateMipLevel();
+    }
+
+    const float volumeTarget = juce::jlimit(0.0f, 2.0f, 1.0f + offsets[ModulationMatrix::Volume]);
+    volumeStep = (volumeTarget - volumeLevel) / static_cast<float>(filterControlInterval);
+
+    samplesUntilFilterUpdate = filterControlInterval;
+}
+
+void SynthVoice::setFilterParameters(float cutoff, float newResonance) {
+    baseCutoffFrequency = juce::jlimit(20.0f, 20000.0f, cutoff);
+    resonance = juce::jmax(0.1f, newResonance);
+    cutoffSmoother.setTargetValue(baseCutoffFrequency);
+    resonanceSmoother.setTargetValue(resonance);
+}
+
+void SynthVoice::setLFORate(float rateHz) {
+    lfo.setRate(rateHz);
+}
+
+void SynthVoice::setFilter(SVFFilterBank* bank, int index) {
+    filterBank = bank;
+    filterIndex = index;
+    ownFilterBank.reset();
+    filterBank->reset(filterIndex);
+    updateModulation();
+}
+
+void SynthVoice::setHotState(VoiceHotState& state, int index) {
+    oscillator.setStateStorage(state.getPhases(index), state.getIncrements(index));
+    float* storage = state.getEnvelopeLevelStorage(index);
+    *storage = *envelopeLevel;
+    envelopeLevel = storage;
+}
+
+void SynthVoice::setModulation(const ModulationMatrix* matrix, const float* globalLFOValue) {
+    modulationMatrix = matrix;
+    globalLFO = globalLFOValue;
+}
+
+void SynthVoice::setFilterControlInterval(int numSamples) {
+    filterControlInterval = juce::jlimit(1, 256, numSamples);
+    samplesUntilFilterUpdate = std::min(samplesUntilFilterUpdate, filterControlInterval);
 }
 
 #include "SynthVoice.h"
@@ -83,49 +162,107 @@ void SynthVoice::prepareToPlay(double sampleRate, int samplesPerBlock) {
     // Update the internal sample rate stored in the class
     this->sampleRate = sampleRate;  // Assuming you have a member variable 'sampleRate' to store the current rate
 
-    // Setup the process specification with the current host sample rate and block size
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;  // Assuming mono processing, adjust if stereo or more channels are required
-
-    // Prepare the filter with the specified processing configuration
-    filter.prepare(spec);
-
-    // Optionally, you could reinitialize or update other processing blocks here
-    initializeWavetable();  // Reinitialize the wavetable if needed
+    // Smoothers restart at their targets; there's nothing to glide from yet
+    cutoffSmoother.reset(sampleRate, parameterSmoothingSecs);
+    cutoffSmoother.setCurrentAndTargetValue(baseCutoffFrequency);
+    resonanceSmoother.reset(sampleRate, parameterSmoothingSecs);
+    resonanceSmoother.setCurrentAndTargetValue(resonance);
+
+    // Prepare the filter for the new rate and recalculate its coefficients straight
+    // away; a shared bank is prepared by its owner. A voice that was never given
+    // one makes its own here, so a synth's pool doesn't build and drop hundreds.
+    if (filterBank == nullptr) {
+        ownFilterBank = std::make_unique<SVFFilterBank>(1);
+        filterBank = ownFilterBank.get();
+        filterIndex = 0;
+    }
+    if (ownFilterBank != nullptr) {
+        ownFilterBank->prepare(sampleRate);
+    } else {
+        filterBank->reset(filterIndex);
+    }
+    lfo.prepare(sampleRate);
+    updateModulation();
+    envelope.setSampleRate(sampleRate);
 
     // Debug output to confirm the settings (you can remove this line in production)
     DBG("SynthVoice prepared: Sample Rate = " << sampleRate << ", Max Block Size = " << samplesPerBlock);
 }
 
-float SynthVoice::getNextSample() {
-    float sample = 0.0f;
-    if (active) {
-        updateFilter(); // Ensure filter is updated each sample
+void SynthVoice::renderBlock(float* out, int numSamples) {
+    SynthVoice* self = this;
+    renderGroup(&self, 1, out, numSamples);
+}
 
-        for (int i = 0; i < unisonSize; ++i) {
-            float detuneFactor = detuneOffsets.size() > i ? detuneOffsets[i] : 1.0f;
-            int index = static_cast<int>(fmod(currentSampleIndex * detuneFactor, wavetableSize));
-            float rawSample = wavetable[currentWaveform][index];
+void SynthVoice::renderGroup(SynthVoice* const* voices, int numVoices, float* out, int numSamples) {
+    constexpr int laneCount = SVFFilterBank::laneCount;
+    jassert(numVoices <= laneCount);
+
+    // One row of laneCount samples per time step, a lane per voice
+    alignas(64) float lanes[maxChunkSize * laneCount];
+    SynthVoice* sounding[laneCount];
+    int filters[laneCount];
+
+    int done = 0;
+    while (done < numSamples) {
+        // Stretches end at the next modulation update of any voice in the group,
+        // so coefficient targets only ever change between filter runs
+        int length = std::min(numSamples - done, maxChunkSize);
+        int numSounding = 0;
+        for (int i = 0; i < numVoices; ++i) {
+            auto* voice = voices[i];
+            if (!voice->active || voice->wavetable == nullptr) continue;
+            if (voice->samplesUntilFilterUpdate == 0) voice->updateModulation();
+            length = std::min(length, voice->samplesUntilFilterUpdate);
+            jassert(voice->filterBank == voices[0]->filterBank);
+            filters[numSounding] = voice->filterIndex;
+            sounding[numSounding++] = voice;
+        }
+        if (numSounding == 0) return;
 
-            // Prepare for processing
-            juce::AudioBuffer<float> buffer(1, 1); // Create a buffer with 1 channel and 1 sample
-            buffer.setSample(0, 0, rawSample); // Set the sample in the buffer
+        std::fill(lanes, lanes + length * laneCount, 0.0f);
+        for (int lane = 0; lane < numSounding; ++lane) {
+            sounding[lane]->renderOscillator(lanes + lane, length);
+        }
 
-            // Wrap the buffer into an AudioBlock
-            juce::dsp::AudioBlock<float> block(buffer);
-            juce::dsp::ProcessContextReplacing<float> context(block);
-            filter.process(context);
+        // The filter is linear, so running it once on the layer sum is
+        // equivalent to filtering each unison layer
+        sounding[0]->filterBank->process(filters, numSounding, lanes, length);
 
-            // Retrieve the processed sample
-            sample += buffer.getSample(0, 0);
-            currentSampleIndex += increment;
-            if (currentSampleIndex >= wavetableSize) currentSampleIndex -= wavetableSize;
+        for (int lane = 0; lane < numSounding; ++lane) {
+            sounding[lane]->applyEnvelope(lanes + lane, out + done, length);
         }
-        sample /= unisonSize;
+        done += length;
+    }
+}
+
+void SynthVoice::renderOscillator(float* dest, int numSamples) {
+    float chunk[maxChunkSize];
+    const float* table = wavetable->getTable(currentWaveform, mipLevel);
+
+    // Every unison layer runs its own detuned phase
+    oscillator.render(table, WavetableBank::tableSize, chunk, numSamples);
+    for (int sample = 0; sample < numSamples; ++sample) {
+        dest[sample * SVFFilterBank::laneCount] = chunk[sample];
+    }
+}
+
+void SynthVoice::applyEnvelope(const float* filtered, float* out, int numSamples) {
+    // Envelope gains for the whole stretch; the modulated gain ramps to the
+    // target set at the last control update
+    float gains[maxChunkSize];
+    envelope.render(gains, numSamples);
+    for (int sample = 0; sample < numSamples; ++sample) {
+        out[sample] += filtered[sample * SVFFilterBank::laneCount] * gains[sample] * volumeLevel;
+        volumeLevel += volumeStep;
+    }
+    samplesUntilFilterUpdate -= numSamples;
+    samplesSinceUpdate += numSamples;
+    *envelopeLevel = envelope.getCurrentLevel();
+
+    if (!envelope.isActive()) {
+        active = false;
     }
-    return sample;
 }
 
 
@@ -134,21 +271,14 @@ bool SynthVoice::isActive() const {
 }
 
 void SynthVoice::setUnisonSize(int size) {
-    unisonSize = size;
-    calculateDetuneOffsets();
+    oscillator.setNumLayers(size);
+    updateMipLevel();
 }
 
 void SynthVoice::setDetuneAmount(float detune) {
     detuneAmount = detune;
-    calculateDetuneOffsets();
-}
-
-void SynthVoice::calculateDetuneOffsets() {
-    detuneOffsets.resize(unisonSize);
-    for (int i = 0; i < unisonSize; ++i) {
-        float offset = (i - unisonSize / 2) * detuneAmount;
-        detuneOffsets[i] = pow(2.0f, offset / 12.0f);
-    }
+    oscillator.setDetune(juce::jmax(0.0f, detuneAmount + detuneOffset));
+    updateMipLevel();
 }
 
 float SynthVoice::midiNoteToFrequency(int midiNoteNumber) const {
@@ -156,5 +286,5 @@ float SynthVoice::midiNoteToFrequency(int midiNoteNumber) const {
 }
 
 float SynthVoice::getSampleRate() const {
-    return 48000.0f; // Replace with the actual sample rate from your audio engine context
+    return sampleRate;
 }
@@ -1,6 +1,13 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "BlockEnvelope.h"
+#include "ModulationMatrix.h"
+#include "SVFFilterBank.h"
+#include "TableLFO.h"
+#include "UnisonOscillator.h"
+#include "VoiceHotState.h"
+#include "WavetableBank.h"
 #include <vector>
 #include <array>
 #include <cmath>
@@ -11,60 +18,111 @@ public:
     SynthVoice();
     ~SynthVoice() = default;
 
-    void initializeWavetable();
     void prepareToPlay(double sampleRate, int samplesPerBlock);
     void startNote(int midiNoteNumber, float velocity);
     void stopNote(bool allowTailOff);
     int getNoteNumber() const;
-    float getNextSample();
     bool isActive() const;
+    float getCurrentLevel() const { return *envelopeLevel; }  // Last envelope gain, for voice stealing
+
+    // Renders numSamples of this voice and adds them into out. Oscillator,
+    // filter and envelope run chunk by chunk on a fixed stack buffer, so the
+    // call never allocates.
+    void renderBlock(float* out, int numSamples);
+
+    // The same for up to SVFFilterBank::laneCount voices at once, summed into
+    // out. Their filters run side by side in SIMD lanes, so they must all use
+    // the same bank.
+    static void renderGroup(SynthVoice* const* voices, int numVoices, float* out, int numSamples);
+
+    // Points the voice at its filter in a bank shared with other voices. A voice
+    // prepared without one makes a private one-filter bank.
+    void setFilter(SVFFilterBank* bank, int index);
+    // Moves the oscillator phases and envelope level into row index of a
+    // pool-wide array; the state must outlive the voice's use of it
+    void setHotState(VoiceHotState& state, int index);
 
     void setUnisonSize(int size);
     void setDetuneAmount(float detune);
-    void setWavetable(const std::array<std::vector<float>, 4>& newWavetable);
-    void updateFilter();
+    // The bank is shared with every other voice and must outlive its use here;
+    // WavetableSynthesizer only swaps it between blocks on the audio thread
+    void setWavetable(const WavetableBank* newWavetable);
+    void setWaveform(int waveformIndex);
+    void updateModulation();
+
+    // Number of samples between modulation updates. The filter coefficients and
+    // modulated gain are interpolated across each interval; 1 recalculates them
+    // every sample.
+    void setFilterControlInterval(int numSamples);
+    // Brings the next update forward, so voices started at different times
+    // still update together and a group isn't cut into short stretches
+    void alignControlUpdates(int samplesUntilNextUpdate) {
+        samplesUntilFilterUpdate = juce::jlimit(1, filterControlInterval, samplesUntilNextUpdate);
+    }
 
-    // Update the ADSR parameters and re-apply to the ADSR envelope
+    // Update the ADSR parameters; a sounding note picks them up at its next stage
     void updateADSR(float attack, float decay, float sustain, float release) {
-        adsrParams = {attack, decay, sustain, release};
-        adsr.setParameters(adsrParams);
+        envelope.setParameters({ attack, decay, sustain, release });
     }
 
-    float lfoValue() const;  // Calculates and returns the current LFO value based on the phase
+    // New filter targets; the voice glides to them over the smoothing time,
+    // advancing once per filter control interval
+    void setFilterParameters(float cutoff, float resonance);
+    // Frequency of this voice's own LFO; how far it swings what is up to the matrix
+    void setLFORate(float rateHz);
+
+    // Both are owned by the synth and only read here, once per control interval.
+    // Without a matrix the voice is unmodulated.
+    void setModulation(const ModulationMatrix* matrix, const float* globalLFOValue);
 
 private:
     float midiNoteToFrequency(int midiNoteNumber) const;
     float getSampleRate() const;
+    // renderGroup's stages: oscillator into every laneCount-th sample of dest,
+    // then envelope and modulated gain from the filtered lane into out
+    void renderOscillator(float* dest, int numSamples);
+    void applyEnvelope(const float* filtered, float* out, int numSamples);
+    void updateMipLevel();
+
+    static constexpr int maxChunkSize = 64;  // Samples rendered per internal pass
 
     bool active;
     float frequency;
     int midiNoteNumber;
-    double currentSampleIndex;
-    double increment;
     float velocity;
     float amplitude;
+    float* envelopeLevel;  // ownEnvelopeLevel until setHotState
+    float ownEnvelopeLevel = 0.0f;
     int currentWaveform;
-    std::array<std::vector<float>, 4> wavetable;
-    static constexpr size_t wavetableSize = 2048;
-    std::vector<float> detuneOffsets;
-    int unisonSize;
-    float detuneAmount;
+    int mipLevel;  // Band-limited table level for the current pitch and detune
+    const WavetableBank* wavetable;
+    UnisonOscillator oscillator;
 
-    // ADSR envelope and parameters
-    juce::ADSR adsr;
-    juce::ADSR::Parameters adsrParams;
+    BlockEnvelope envelope;
 
     // DSP related members
-    juce::dsp::IIR::Filter<float> filter;
-    float lfoPhase;
-    float lfoRate;
-    float lfoDepth;
+    SVFFilterBank* filterBank = nullptr;
+    int filterIndex = 0;
+    std::unique_ptr<SVFFilterBank> ownFilterBank;  // Only if no shared bank was set
+    int filterControlInterval;
+    int samplesUntilFilterUpdate;
+    int samplesSinceUpdate = 0;  // Rendered since the last updateModulation
+    TableLFO lfo;
+    const ModulationMatrix* modulationMatrix = nullptr;
+    const float* globalLFO = nullptr;
+    float pitchOffset = 0.0f;   // Semitones, as last applied to the oscillator
+    float detuneOffset = 0.0f;
+    float detuneAmount = 0.0f;  // Unmodulated unison spread
+    float volumeLevel = 1.0f;   // Modulated gain, ramped across each interval
+    float volumeStep = 0.0f;
     float baseCutoffFrequency;
+    float resonance;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> cutoffSmoother;
+    juce::SmoothedValue<float> resonanceSmoother;
+    static constexpr double parameterSmoothingSecs = 0.05;
 
     float sampleRate;  // Dynamic sample rate used across the class
 
-    void calculateDetuneOffsets();
-
     // This ensures that all DSP objects use the most current sample rate
     void updateDSPBlockSizeAndRate();
 };
@@ -0,0 +1,40 @@
+#include "TableLFO.h"
+#include <array>
+
+const float* TableLFO::getTable(Shape shape) {
+    // One table per shape with a guard point, built on first use and shared
+    // by every LFO in the process
+    static const auto tables = [] {
+        std::array<std::array<float, tableSize + 1>, NumShapes> result {};
+        for (int i = 0; i <= tableSize; ++i) {
+            const float phase = static_cast<float>(i % tableSize) / tableSize;
+            result[Sine][i] = std::sin(juce::MathConstants<float>::twoPi * phase);
+            result[Triangle][i] = 4.0f * std::abs(phase - 0.5f) - 1.0f;
+            result[Saw][i] = 2.0f * phase - 1.0f;
+            result[Square][i] = phase < 0.5f ? 1.0f : -1.0f;
+        }
+        return result;
+    }();
+    return tables[static_cast<size_t>(juce::jlimit(0, NumShapes - 1, static_cast<int>(shape)))].data();
+}
+
+void TableLFO::prepare(double newSampleRate) {
+    sampleRate = newSampleRate;
+    setRate(rate);
+}
+
+void TableLFO::setRate(float rateHz) {
+    rate = juce::jmax(0.0f, rateHz);
+    increment = static_cast<float>(rate / sampleRate);
+}
+
+void TableLFO::setShape(Shape newShape) {
+    table = getTable(newShape);
+}
+
+float TableLFO::getValue() const {
+    const float position = phase * tableSize;
+    const int index = juce::jmin(static_cast<int>(position), tableSize - 1);
+    const float fraction = position - static_cast<float>(index);
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
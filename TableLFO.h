@@ -0,0 +1,34 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Low-frequency oscillator read from small shared wavetables. It's meant to be
+// advanced at control rate, a whole interval at a time, so a voice pays for
+// one interpolated lookup per update rather than a sin() per sample.
+class TableLFO {
+public:
+    enum Shape { Sine, Triangle, Saw, Square, NumShapes };
+
+    void prepare(double newSampleRate);
+    void setRate(float rateHz);
+    void setShape(Shape newShape);
+    void reset() { phase = 0.0f; }
+
+    // Bipolar output, [-1, 1], at the current phase
+    float getValue() const;
+    // Moves the phase on by numSamples
+    void advance(int numSamples) {
+        phase += increment * static_cast<float>(numSamples);
+        phase -= std::floor(phase);
+    }
+
+private:
+    static constexpr int tableSize = 256;
+    static const float* getTable(Shape shape);
+
+    double sampleRate = 48000.0;
+    float rate = 1.0f;
+    float increment = 1.0f / 48000.0f;  // Cycles per sample
+    float phase = 0.0f;                 // [0, 1)
+    const float* table = getTable(Sine);
+};
@@ -0,0 +1,87 @@
+#include "UnisonOscillator.h"
+
+UnisonOscillator::UnisonOscillator()
+    : phases(ownPhases), increments(ownIncrements), numLayers(1), detuneSemitones(0.0f), baseIncrement(0.0) {
+    std::fill(std::begin(detuneFactors), std::end(detuneFactors), 1.0f);
+    resetPhases();
+    updateIncrements();
+}
+
+void UnisonOscillator::setNumLayers(int newNumLayers) {
+    numLayers = juce::jlimit(1, maxLayers, newNumLayers);
+    setDetune(detuneSemitones);
+}
+
+void UnisonOscillator::setDetune(float semitones) {
+    detuneSemitones = semitones;
+    for (int i = 0; i < maxLayers; ++i) {
+        float offset = (i - numLayers / 2) * detuneSemitones;
+        detuneFactors[i] = i < numLayers ? std::pow(2.0f, offset / 12.0f) : 0.0f;
+    }
+    updateIncrements();
+}
+
+void UnisonOscillator::setFrequency(double cyclesPerSample) {
+    baseIncrement = cyclesPerSample;
+    updateIncrements();
+}
+
+double UnisonOscillator::getMaxIncrement() const {
+    return *std::max_element(increments, increments + maxLayers);
+}
+
+void UnisonOscillator::resetPhases() {
+    std::fill(phases, phases + maxLayers, 0.0f);
+}
+
+void UnisonOscillator::setStateStorage(float* newPhases, float* newIncrements) {
+    std::copy(phases, phases + maxLayers, newPhases);
+    std::copy(increments, increments + maxLayers, newIncrements);
+    phases = newPhases;
+    increments = newIncrements;
+}
+
+void UnisonOscillator::updateIncrements() {
+    // Unused lanes get a zero increment so whole registers can be advanced blindly
+    for (int i = 0; i < maxLayers; ++i) {
+        increments[i] = static_cast<float>(juce::jlimit(0.0, 0.5, baseIncrement * detuneFactors[i]));
+    }
+}
+
+void UnisonOscillator::render(const float* table, int tableSize, float* out, int numSamples) {
+    const float layerGain = 1.0f / numLayers;
+    const float scale = static_cast<float>(tableSize);
+
+#if JUCE_USE_SIMD
+    using FloatVec = juce::dsp::SIMDRegister<float>;
+    constexpr int laneCount = static_cast<int>(FloatVec::size());
+    static_assert(maxLayers % laneCount == 0, "Layer arrays must hold whole registers");
+    const int numGroups = (numLayers + laneCount - 1) / laneCount;
+    const auto one = FloatVec::expand(1.0f);
+#endif
+
+    for (int sample = 0; sample < numSamples; ++sample) {
+        float sum = 0.0f;
+        for (int i = 0; i < numLayers; ++i) {
+            const float position = phases[i] * scale;
+            const int index = static_cast<int>(position);
+            const float fraction = position - static_cast<float>(index);
+            sum += table[index] + fraction * (table[index + 1] - table[index]);
+        }
+        out[sample] = sum * layerGain;
+
+#if JUCE_USE_SIMD
+        for (int group = 0; group < numGroups; ++group) {
+            float* groupPhases = phases + group * laneCount;
+            auto phase = FloatVec::fromRawArray(groupPhases) + FloatVec::fromRawArray(increments + group * laneCount);
+            phase = phase - (one & FloatVec::greaterThanOrEqual(phase, one));
+            phase.copyToRawArray(groupPhases);
+        }
+#else
+        for (int i = 0; i < numLayers; ++i) {
+            phases[i] += increments[i];
+            if (phases[i] >= 1.0f) phases[i] -= 1.0f;
+        }
+#endif
+    }
+}
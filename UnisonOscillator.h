@@ -0,0 +1,57 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+#include <algorithm>
+
+// Unison wavetable oscillator that keeps its per-layer phases and increments in
+// aligned structure-of-arrays form. Phase accumulation and wrapping run on
+// juce::dsp::SIMDRegister lanes (4 or 8 layers per instruction); only the
+// interpolated table lookup itself is a scalar gather.
+class UnisonOscillator {
+public:
+    static constexpr int maxLayers = 16;  // Multiple of every SIMD lane count we build for
+
+    UnisonOscillator();
+
+    void setNumLayers(int newNumLayers);
+    int getNumLayers() const { return numLayers; }
+
+    // Spread between neighbouring layers, in semitones
+    void setDetune(float semitones);
+
+    // Base pitch in table cycles per sample; each layer is detuned from it
+    void setFrequency(double cyclesPerSample);
+
+    // Puts every layer back to phase zero, so a note starts like a single oscillator
+    void resetPhases();
+
+    // Highest per-layer increment, used to choose a band-limited table
+    double getMaxIncrement() const;
+
+    // Moves the phases and increments (maxLayers floats each, 32-byte aligned)
+    // into storage owned elsewhere, such as a pool-wide VoiceHotState, so
+    // rendering many voices walks one contiguous array
+    void setStateStorage(float* newPhases, float* newIncrements);
+
+    // Writes numSamples of the layer average into out. The table must hold
+    // tableSize + 1 samples (guard point) since lookups interpolate linearly.
+    void render(const float* table, int tableSize, float* out, int numSamples);
+
+private:
+    void updateIncrements();
+
+    float* phases;      // Normalised phase, [0, 1)
+    float* increments;  // Cycles per sample, zero for unused lanes
+    float detuneFactors[maxLayers];
+
+    // Where phases and increments live until setStateStorage moves them
+    alignas(32) float ownPhases[maxLayers];
+    alignas(32) float ownIncrements[maxLayers];
+
+    int numLayers;
+    float detuneSemitones;
+    double baseIncrement;
+
+    JUCE_DECLARE_NON_COPYABLE(UnisonOscillator)
+};
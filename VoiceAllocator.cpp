@@ -0,0 +1,88 @@
+#include "VoiceAllocator.h"
+
+void VoiceAllocator::setNumVoices(int numVoices) {
+    activeVoices.assign(numVoices, -1);
+    activeListPosition.assign(numVoices, -1);
+    numActiveVoices = 0;
+
+    // Hand out low indices first
+    freeVoices.resize(numVoices);
+    for (int i = 0; i < numVoices; ++i) {
+        freeVoices[i] = numVoices - 1 - i;
+    }
+    numFreeVoices = numVoices;
+
+    voiceNotes.assign(numVoices, -1);
+    voiceReleased.assign(numVoices, false);
+    voiceStartOrder.assign(numVoices, 0);
+    nextStartOrder = 0;
+
+    noteHeads.fill(-1);
+    nextVoiceForNote.assign(numVoices, -1);
+
+    setPolyphony(polyphony.load());
+}
+
+void VoiceAllocator::setPolyphony(int maxActiveVoices) {
+    polyphony.store(juce::jlimit(1, juce::jmax(1, getNumVoices()), maxActiveVoices));
+}
+
+void VoiceAllocator::voiceFinished(int voiceIndex) {
+    if (activeListPosition[voiceIndex] < 0) return;
+
+    unlinkFromNote(voiceIndex);
+    removeFromActiveList(voiceIndex);
+    voiceNotes[voiceIndex] = -1;
+    freeVoices[numFreeVoices++] = voiceIndex;
+}
+
+int VoiceAllocator::takeFreeVoice() {
+    return numFreeVoices > 0 ? freeVoices[--numFreeVoices] : -1;
+}
+
+int VoiceAllocator::findOldestVoice(bool releasedOnly) const {
+    int oldest = -1;
+    for (int i = 0; i < numActiveVoices; ++i) {
+        const int voiceIndex = activeVoices[i];
+        if (releasedOnly && !voiceReleased[voiceIndex]) continue;
+
+        if (oldest < 0 || voiceStartOrder[voiceIndex] < voiceStartOrder[oldest]) {
+            oldest = voiceIndex;
+        }
+    }
+    return oldest;
+}
+
+void VoiceAllocator::addToActiveList(int voiceIndex) {
+    activeListPosition[voiceIndex] = numActiveVoices;
+    activeVoices[numActiveVoices++] = voiceIndex;
+}
+
+void VoiceAllocator::removeFromActiveList(int voiceIndex) {
+    // Swap-remove: move the last active voice into the freed slot
+    const int position = activeListPosition[voiceIndex];
+    const int lastVoice = activeVoices[--numActiveVoices];
+    activeVoices[position] = lastVoice;
+    activeListPosition[lastVoice] = position;
+    activeListPosition[voiceIndex] = -1;
+}
+
+void VoiceAllocator::linkToNote(int voiceIndex, int midiNoteNumber) {
+    nextVoiceForNote[voiceIndex] = noteHeads[midiNoteNumber];
+    noteHeads[midiNoteNumber] = voiceIndex;
+}
+
+void VoiceAllocator::unlinkFromNote(int voiceIndex) {
+    const int note = voiceNotes[voiceIndex];
+    if (note < 0 || voiceReleased[voiceIndex]) return;  // Released voices are already unlinked
+
+    // Chains only hold the voices sharing one note, so this walk is short
+    int* link = &noteHeads[note];
+    while (*link >= 0 && *link != voiceIndex) {
+        link = &nextVoiceForNote[*link];
+    }
+    if (*link == voiceIndex) {
+        *link = nextVoiceForNote[voiceIndex];
+    }
+    nextVoiceForNote[voiceIndex] = -1;
+}
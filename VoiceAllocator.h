@@ -0,0 +1,156 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Bookkeeping for a fixed pool of synth voices: a compact list of the voices
+// currently sounding, a note -> voice table for O(1) note-off lookup, and voice
+// stealing once the polyphony limit is reached. The allocator only deals in
+// voice indices; the owner starts, stops and renders the voices themselves.
+// Everything except the setters is called from the audio thread.
+class VoiceAllocator {
+public:
+    enum class StealingPolicy {
+        Oldest,    // Steal the voice that started first
+        Quietest,  // Steal the voice with the lowest envelope level
+        SameNote   // Retrigger a voice already playing the note, else steal the oldest
+    };
+
+    // Sizes every table for the voice pool. Allocates, so call it before playback.
+    void setNumVoices(int numVoices);
+    int getNumVoices() const { return static_cast<int>(voiceNotes.size()); }
+
+    // Safe to call from any thread; takes effect from the next note-on
+    void setPolyphony(int maxActiveVoices);
+    int getPolyphony() const { return polyphony.load(); }
+    void setStealingPolicy(StealingPolicy newPolicy) { stealingPolicy.store(newPolicy); }
+
+    // Chooses the voice that should play this note and records it as held.
+    // getLevel(voiceIndex) is only called for the Quietest policy.
+    template <typename LevelFunction>
+    int startNote(int midiNoteNumber, LevelFunction&& getLevel);
+
+    // Marks every held voice for this note as released and calls
+    // onRelease(voiceIndex) for each; they stay active until voiceFinished().
+    template <typename ReleaseFunction>
+    void releaseNote(int midiNoteNumber, ReleaseFunction&& onRelease);
+
+    // Returns a voice whose envelope has ended to the free pool
+    void voiceFinished(int voiceIndex);
+
+    // Indices of the voices currently sounding, in no particular order
+    const int* getActiveVoices() const { return activeVoices.data(); }
+    int getNumActiveVoices() const { return numActiveVoices; }
+
+private:
+    static constexpr int numMidiNotes = 128;
+
+    int takeFreeVoice();
+    template <typename LevelFunction>
+    int findQuietestVoice(LevelFunction& getLevel, bool releasedOnly) const;
+    int findOldestVoice(bool releasedOnly) const;
+    void addToActiveList(int voiceIndex);
+    void removeFromActiveList(int voiceIndex);
+    void linkToNote(int voiceIndex, int midiNoteNumber);
+    void unlinkFromNote(int voiceIndex);
+
+    std::atomic<int> polyphony { 16 };
+    std::atomic<StealingPolicy> stealingPolicy { StealingPolicy::Oldest };
+
+    std::vector<int> activeVoices;        // First numActiveVoices entries are sounding
+    std::vector<int> activeListPosition;  // Voice -> index into activeVoices, or -1
+    int numActiveVoices = 0;
+    std::vector<int> freeVoices;          // Stack of idle voice indices
+    int numFreeVoices = 0;
+
+    std::vector<int> voiceNotes;          // Note each voice was started with
+    std::vector<bool> voiceReleased;      // Note-off received
+    std::vector<uint64_t> voiceStartOrder;
+    uint64_t nextStartOrder = 0;
+
+    // Held voices per note as singly linked chains, so note-off never scans
+    std::array<int, numMidiNotes> noteHeads;
+    std::vector<int> nextVoiceForNote;
+};
+
+template <typename LevelFunction>
+int VoiceAllocator::startNote(int midiNoteNumber, LevelFunction&& getLevel) {
+    jassert(midiNoteNumber >= 0 && midiNoteNumber < numMidiNotes);
+    int voiceIndex = -1;
+    const auto policy = stealingPolicy.load();
+
+    if (policy == StealingPolicy::SameNote) {
+        // Prefer a held voice for this note, then any released one still ringing
+        voiceIndex = noteHeads[midiNoteNumber];
+        for (int i = 0; voiceIndex < 0 && i < numActiveVoices; ++i) {
+            if (voiceNotes[activeVoices[i]] == midiNoteNumber) {
+                voiceIndex = activeVoices[i];
+            }
+        }
+    }
+
+    if (voiceIndex < 0 && numActiveVoices < polyphony.load()) {
+        voiceIndex = takeFreeVoice();
+    }
+
+    if (voiceIndex < 0 && numActiveVoices > 0) {
+        // Released voices are cheaper to lose than held ones
+        if (policy == StealingPolicy::Quietest) {
+            voiceIndex = findQuietestVoice(getLevel, true);
+            if (voiceIndex < 0) voiceIndex = findQuietestVoice(getLevel, false);
+        } else {
+            voiceIndex = findOldestVoice(true);
+            if (voiceIndex < 0) voiceIndex = findOldestVoice(false);
+        }
+    }
+
+    if (voiceIndex < 0) return -1;
+
+    // Restarting a voice that is already sounding keeps it in the active list
+    unlinkFromNote(voiceIndex);
+    if (activeListPosition[voiceIndex] < 0) {
+        addToActiveList(voiceIndex);
+    }
+
+    voiceNotes[voiceIndex] = midiNoteNumber;
+    voiceReleased[voiceIndex] = false;
+    voiceStartOrder[voiceIndex] = nextStartOrder++;
+    linkToNote(voiceIndex, midiNoteNumber);
+    return voiceIndex;
+}
+
+template <typename ReleaseFunction>
+void VoiceAllocator::releaseNote(int midiNoteNumber, ReleaseFunction&& onRelease) {
+    if (midiNoteNumber < 0 || midiNoteNumber >= numMidiNotes) return;
+
+    int voiceIndex = noteHeads[midiNoteNumber];
+    noteHeads[midiNoteNumber] = -1;
+
+    while (voiceIndex >= 0) {
+        const int next = nextVoiceForNote[voiceIndex];
+        nextVoiceForNote[voiceIndex] = -1;
+        voiceReleased[voiceIndex] = true;
+        onRelease(voiceIndex);
+        voiceIndex = next;
+    }
+}
+
+template <typename LevelFunction>
+int VoiceAllocator::findQuietestVoice(LevelFunction& getLevel, bool releasedOnly) const {
+    int quietest = -1;
+    float lowestLevel = 0.0f;
+    for (int i = 0; i < numActiveVoices; ++i) {
+        const int voiceIndex = activeVoices[i];
+        if (releasedOnly && !voiceReleased[voiceIndex]) continue;
+
+        const float level = getLevel(voiceIndex);
+        if (quietest < 0 || level < lowestLevel) {
+            quietest = voiceIndex;
+            lowestLevel = level;
+        }
+    }
+    return quietest;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "UnisonOscillator.h"
+#include <vector>
+
+// The per-voice state touched on every rendered sample, for a whole voice pool,
+// in contiguous arrays indexed by voice. Each voice's unison phases and
+// increments share one cache-line-aligned row, and the envelope levels that
+// voice stealing scans sit side by side. Filter states are kept the same way in
+// SVFFilterBank. What stays in SynthVoice itself is only touched at note
+// starts and control-rate updates.
+class VoiceHotState {
+public:
+    explicit VoiceHotState(int numVoices)
+        : oscillatorRows(static_cast<size_t>(numVoices)),
+          envelopeLevels(static_cast<size_t>(numVoices), 0.0f) {}
+
+    int getNumVoices() const { return static_cast<int>(envelopeLevels.size()); }
+
+    float* getPhases(int voice) { return oscillatorRows[static_cast<size_t>(voice)].phases; }
+    float* getIncrements(int voice) { return oscillatorRows[static_cast<size_t>(voice)].increments; }
+    float* getEnvelopeLevelStorage(int voice) { return &envelopeLevels[static_cast<size_t>(voice)]; }
+    float getEnvelopeLevel(int voice) const { return envelopeLevels[static_cast<size_t>(voice)]; }
+
+private:
+    struct alignas(64) OscillatorRow {
+        float phases[UnisonOscillator::maxLayers] {};
+        float increments[UnisonOscillator::maxLayers] {};
+    };
+
+    std::vector<OscillatorRow> oscillatorRows;
+    std::vector<float> envelopeLevels;
+
+    JUCE_DECLARE_NON_COPYABLE(VoiceHotState)
+};
@@ -0,0 +1,110 @@
+#include "VoiceRenderPool.h"
+#include "AllocationTripwire.h"
+
+VoiceRenderPool::~VoiceRenderPool() {
+    release();
+}
+
+void VoiceRenderPool::prepare(int numWorkers, int maxGroups, int maxBlockSize) {
+    release();
+
+    groupBuffers.assign(static_cast<size_t>(maxGroups), std::vector<float>(static_cast<size_t>(maxBlockSize), 0.0f));
+
+    for (int i = 0; i < numWorkers; ++i) {
+        auto worker = std::make_unique<Worker>(*this);
+        worker->startThread(juce::Thread::Priority::highest);
+        workers.push_back(std::move(worker));
+    }
+}
+
+void VoiceRenderPool::release() {
+    for (auto& worker : workers) {
+        worker->signalThreadShouldExit();
+        worker->wakeEvent.signal();
+    }
+    for (auto& worker : workers) {
+        worker->stopThread(1000);
+    }
+    workers.clear();
+}
+
+void VoiceRenderPool::run(GroupRenderer renderer, void* context, int numGroups, int numSamples) {
+    jassert(numGroups <= getMaxGroups() && numSamples <= static_cast<int>(groupBuffers[0].size()));
+
+    // Close the previous job first, so a straggler can't pair its old claim
+    // state with the new group count below
+    claimState.store(packClaimState(jobGeneration, closedJob));
+
+    jobRenderer = renderer;
+    jobContext = context;
+    jobNumSamples = numSamples;
+    jobNumGroups.store(numGroups, std::memory_order_relaxed);
+    groupsDone.store(0);
+    claimState.store(packClaimState(++jobGeneration, 0), std::memory_order_release);
+
+    if (numSleepingWorkers.load() > 0) {
+        for (auto& worker : workers) {
+            worker->wakeEvent.signal();
+        }
+    }
+
+    // Work alongside the pool, then wait for whatever the workers still hold
+    renderAvailableGroups(jobGeneration);
+    while (groupsDone.load(std::memory_order_acquire) < numGroups) {
+        juce::Thread::yield();
+    }
+}
+
+void VoiceRenderPool::renderAvailableGroups(uint32_t generation) {
+    juce::ScopedNoDenormals noDenormals;  // Flush-to-zero is per thread
+
+    for (;;) {
+        uint64_t state = claimState.load(std::memory_order_acquire);
+        int group = -1;
+        while (group < 0) {
+            if (generationOf(state) != generation) return;
+            if (static_cast<int>(static_cast<uint32_t>(state)) >= jobNumGroups.load(std::memory_order_relaxed)) return;
+
+            if (claimState.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel)) {
+                group = static_cast<int>(static_cast<uint32_t>(state));
+            }
+        }
+
+        float* output = groupBuffers[static_cast<size_t>(group)].data();
+        std::fill(output, output + jobNumSamples, 0.0f);
+        jobRenderer(jobContext, group, output, jobNumSamples);
+        groupsDone.fetch_add(1, std::memory_order_release);
+    }
+}
+
+VoiceRenderPool::Worker::Worker(VoiceRenderPool& owner)
+    : juce::Thread("Voice render worker"), pool(owner) {}
+
+void VoiceRenderPool::Worker::run() {
+    uint32_t lastGeneration = generationOf(pool.claimState.load());
+
+    while (!threadShouldExit()) {
+        int spins = 0;
+        while (generationOf(pool.claimState.load(std::memory_order_acquire)) == lastGeneration) {
+            if (threadShouldExit()) return;
+
+            if (++spins < spinsBeforeSleeping) continue;
+
+            // Re-check after announcing we're asleep so a job published in
+            // between is never missed; the timeout is only a safety net
+            pool.numSleepingWorkers.fetch_add(1);
+            if (generationOf(pool.claimState.load()) == lastGeneration) {
+                wakeEvent.wait(5);
+            }
+            pool.numSleepingWorkers.fetch_sub(1);
+            spins = 0;
+        }
+
+        lastGeneration = generationOf(pool.claimState.load(std::memory_order_acquire));
+
+        // Workers render on the audio thread's behalf, so they're held to the same
+        // rule while they do; waiting for work isn't covered
+        AllocationTripwire::ScopedAudioThreadGuard allocationGuard;
+        pool.renderAvailableGroups(lastGeneration);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+// Small pool of render threads for splitting one block of voice rendering into
+// independent groups. Each group renders into its own preallocated buffer and
+// the caller sums them in group order afterwards, so the mix is identical no
+// matter which thread rendered what. Groups are claimed from a shared atomic
+// counter by the workers and the calling thread alike; idle workers spin
+// briefly and then sleep until the next block.
+class VoiceRenderPool {
+public:
+    // Renders group groupIndex into output (already cleared, numSamples long)
+    using GroupRenderer = void (*)(void* context, int groupIndex, float* output, int numSamples);
+
+    VoiceRenderPool() = default;
+    ~VoiceRenderPool();
+
+    // Starts numWorkers threads and allocates maxGroups buffers of maxBlockSize
+    // samples. Call from prepareToPlay, never while run() may be executing.
+    void prepare(int numWorkers, int maxGroups, int maxBlockSize);
+    void release();
+
+    bool isRunning() const { return !workers.empty(); }
+    int getMaxGroups() const { return static_cast<int>(groupBuffers.size()); }
+
+    // Renders numGroups groups across the pool and returns when all are done.
+    // Allocation-free; call from the audio thread only.
+    void run(GroupRenderer renderer, void* context, int numGroups, int numSamples);
+
+    const float* getGroupBuffer(int groupIndex) const { return groupBuffers[groupIndex].data(); }
+
+private:
+    class Worker : public juce::Thread {
+    public:
+        explicit Worker(VoiceRenderPool& owner);
+        void run() override;
+
+        juce::WaitableEvent wakeEvent;
+
+    private:
+        VoiceRenderPool& pool;
+    };
+
+    void renderAvailableGroups(uint32_t generation);
+
+    // Job generation in the top 32 bits, next unclaimed group in the bottom 32.
+    // Claiming through one word means a worker still finishing an old job can
+    // never take a group from the next one.
+    static uint64_t packClaimState(uint32_t generation, uint32_t group) { return (static_cast<uint64_t>(generation) << 32) | group; }
+    static uint32_t generationOf(uint64_t state) { return static_cast<uint32_t>(state >> 32); }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::vector<float>> groupBuffers;
+
+    // Current job; written by the audio thread before claimState is published
+    GroupRenderer jobRenderer = nullptr;
+    void* jobContext = nullptr;
+    int jobNumSamples = 0;
+    std::atomic<int> jobNumGroups { 0 };  // A straggling worker may read it while the next job is set up
+    uint32_t jobGeneration = 0;
+    std::atomic<uint64_t> claimState { 0 };
+    std::atomic<int> groupsDone { 0 };
+    std::atomic<int> numSleepingWorkers { 0 };
+
+    static constexpr int spinsBeforeSleeping = 2000;
+    static constexpr uint32_t closedJob = 0x7fffffff;  // Past any group count, far from wrapping
+};
@@ -0,0 +1,51 @@
+#include "WavetableBank.h"
+
+WavetableBank::WavetableBank(int numWaveforms)
+    : numWaveforms(numWaveforms),
+      tables(static_cast<size_t>(numWaveforms * numMipLevels), std::vector<float>(tableSize + 1, 0.0f)) {}
+
+void WavetableBank::setWaveform(int waveformIndex, const std::vector<float>& singleCycle) {
+    jassert(waveformIndex >= 0 && waveformIndex < numWaveforms);
+    jassert(singleCycle.size() == static_cast<size_t>(tableSize));
+
+    juce::dsp::FFT fft(tableOrder);
+    std::vector<float> spectrum(2 * tableSize, 0.0f);
+    std::copy(singleCycle.begin(), singleCycle.end(), spectrum.begin());
+    fft.performRealOnlyForwardTransform(spectrum.data());
+
+    std::vector<float> levelData(2 * tableSize);
+
+    for (int level = 0; level < numMipLevels; ++level) {
+        const int maxHarmonic = (tableSize / 2) >> level;
+        std::copy(spectrum.begin(), spectrum.end(), levelData.begin());
+
+        // Drop DC, Nyquist and every bin above the harmonic limit, on both
+        // mirrored halves of the spectrum
+        levelData[0] = levelData[1] = 0.0f;
+        levelData[tableSize] = levelData[tableSize + 1] = 0.0f;
+        for (int bin = maxHarmonic + 1; bin < tableSize - maxHarmonic; ++bin) {
+            levelData[2 * bin] = 0.0f;
+            levelData[2 * bin + 1] = 0.0f;
+        }
+
+        fft.performRealOnlyInverseTransform(levelData.data());
+
+        auto& table = tables[static_cast<size_t>(waveformIndex * numMipLevels + level)];
+        std::copy(levelData.begin(), levelData.begin() + tableSize, table.begin());
+        table[tableSize] = table[0];
+    }
+}
+
+const float* WavetableBank::getTable(int waveformIndex, int mipLevel) const {
+    return tables[static_cast<size_t>(waveformIndex * numMipLevels + mipLevel)].data();
+}
+
+int WavetableBank::getMipLevelForIncrement(double cyclesPerSample) {
+    int level = 0;
+    int harmonics = tableSize / 2;  // Highest harmonic kept by the current level
+    while (level < numMipLevels - 1 && harmonics * cyclesPerSample > 0.5) {
+        harmonics /= 2;
+        ++level;
+    }
+    return level;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+// Set of single-cycle waveforms, each stored as a chain of band-limited mip
+// levels. Level 0 keeps every harmonic the table can hold and each following
+// level halves that count, so playback can pick the richest level whose top
+// harmonic still sits below Nyquist for the note being played.
+//
+// A bank is filled once and then treated as immutable: voices only ever hold a
+// const pointer to it, and it is shared by reference count instead of copied.
+class WavetableBank : public juce::ReferenceCountedObject {
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<WavetableBank>;
+
+    static constexpr int tableOrder = 11;
+    static constexpr int tableSize = 1 << tableOrder;  // Samples per cycle
+    static constexpr int numMipLevels = tableOrder;     // Level k keeps harmonics 1 to (tableSize / 2) >> k
+
+    explicit WavetableBank(int numWaveforms);
+
+    // Band-limits a single cycle of tableSize samples into every mip level of the
+    // given slot. Runs one FFT per level, so call it while building the bank only,
+    // before it is handed to a synthesizer.
+    void setWaveform(int waveformIndex, const std::vector<float>& singleCycle);
+
+    int getNumWaveforms() const { return numWaveforms; }
+
+    // Returns tableSize + 1 samples; the last one repeats the first so linear
+    // interpolation never has to wrap
+    const float* getTable(int waveformIndex, int mipLevel) const;
+
+    // Lowest (richest) level whose harmonics all stay below Nyquist at this pitch
+    static int getMipLevelForIncrement(double cyclesPerSample);
+
+private:
+    int numWaveforms;
+    std::vector<std::vector<float>> tables;  // Indexed [waveform * numMipLevels + level]
+
+    JUCE_DECLARE_NON_COPYABLE(WavetableBank)
+};
@@ -4,75 +4,219 @@
 #include "Sampler.h"
 
 WavetableSynthesizer::WavetableSynthesizer()
-: masterVolume(1.0f), voices(16) {
-    fillWavetable();
-    for (auto& voice : voices) {
-        voice = std::make_unique<SynthVoice>();
-        voice->setWavetable(wavetables);
+: masterVolume(1.0f), currentSampleRate(48000.0), voices(maxVoices), currentWaveform(Sine) {
+    for (size_t i = 0; i < voices.size(); ++i) {
+        voices[i].setFilter(&filterBank, static_cast<int>(i));
+        voices[i].setHotState(hotState, static_cast<int>(i));
+        voices[i].setModulation(&modulationMatrix, &globalLFOValue);
     }
+    voiceAllocator.setNumVoices(maxVoices);
+
+    // The LFO depth parameter's default
+    modulationMatrix.setRouting(lfoDepthRouting, ModulationMatrix::VoiceLFO, ModulationMatrix::Cutoff, 0.5f);
+    globalLFO.setRate(0.5f);
+
+    auto defaultBank = getDefaultBank();
+    defaultBank->incReferenceCount();
+    swapWavetableBank(defaultBank.get());
 }
 
-WavetableSynthesizer::~WavetableSynthesizer() {}
+WavetableSynthesizer::~WavetableSynthesizer() {
+    activeBank->decReferenceCount();
+}
 
 void WavetableSynthesizer::prepareToPlay(double sampleRate, int samplesPerBlock) {
+    currentSampleRate = sampleRate;
+    globalLFO.prepare(sampleRate);
+    filterBank.prepare(sampleRate);
+    controlPosition = 0;
+    mixBuffer.assign(static_cast<size_t>(samplesPerBlock), 0.0f);
+
     for (auto& voice : voices) {
-        voice->prepareToPlay(sampleRate, samplesPerBlock);
+        voice.prepareToPlay(sampleRate, samplesPerBlock);
+    }
+
+    const int numThreads = numRenderThreads.load();
+    if (numThreads > 0) {
+        renderPool.prepare(numThreads, maxVoices / voicesPerGroup, samplesPerBlock);
+    } else {
+        renderPool.release();
     }
 }
 
 void WavetableSynthesizer::releaseResources() {
-    // Optional: Clean up resources if necessary
+    renderPool.release();
+}
+
+void WavetableSynthesizer::setNumRenderThreads(int numThreads) {
+    numRenderThreads.store(juce::jlimit(0, juce::jmax(0, juce::SystemStats::getNumCpus() - 1), numThreads));
 }
 
-void WavetableSynthesizer::renderNextBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int startSample, int numSamples) {
-    buffer.clear();
+void WavetableSynthesizer::renderNextBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) {
+    if (mixBuffer.empty()) return;  // Not prepared yet
+
+    const float gain = masterVolume * voiceHeadroom;
+    const int chunkCapacity = static_cast<int>(mixBuffer.size());
 
-    for (int sample = 0; sample < numSamples; ++sample) {
-        float mix = 0.0f;
+    // Hosts may pass more samples than announced in prepareToPlay, so render in
+    // chunks that fit the preallocated mix buffer
+    while (numSamples > 0) {
+        const int chunkSize = std::min(numSamples, chunkCapacity);
+        std::fill(mixBuffer.begin(), mixBuffer.begin() + chunkSize, 0.0f);
+        globalLFOValue = globalLFO.getValue();
+        globalLFO.advance(chunkSize);
 
-        for (auto& voice : voices) {
-            if (voice->isActive()) {
-                mix += voice->getNextSample();
-            }
+        updateRenderOrder();
+        if (renderPool.isRunning() && voiceAllocator.getNumActiveVoices() >= minVoicesForParallel) {
+            renderVoicesParallel(chunkSize);
+        } else {
+            renderVoicesSerial(chunkSize);
         }
-        
-        mix *= masterVolume / static_cast<float>(voices.size());
+        releaseFinishedVoices();
+        controlPosition = (controlPosition + chunkSize) % controlInterval;
 
         for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
-            buffer.addSample(channel, startSample + sample, mix);
+            buffer.addFrom(channel, startSample, mixBuffer.data(), chunkSize, gain);
         }
+
+        startSample += chunkSize;
+        numSamples -= chunkSize;
+    }
+}
+
+
+
+void WavetableSynthesizer::updateRenderOrder() {
+    // The allocator's list is in start order with holes swapped over; sorting a
+    // copy costs little next to rendering and keeps neighbouring voices together
+    const int numActive = voiceAllocator.getNumActiveVoices();
+    const int* activeVoices = voiceAllocator.getActiveVoices();
+    std::copy(activeVoices, activeVoices + numActive, renderOrder.begin());
+    std::sort(renderOrder.begin(), renderOrder.begin() + numActive);
+}
+
+void WavetableSynthesizer::renderVoicesSerial(int numSamples) {
+    // Only sounding voices are visited, so idle pool entries cost nothing
+    const int numGroups = (voiceAllocator.getNumActiveVoices() + voicesPerGroup - 1) / voicesPerGroup;
+    for (int group = 0; group < numGroups; ++group) {
+        renderVoiceGroup(this, group, mixBuffer.data(), numSamples);
+    }
+}
+
+void WavetableSynthesizer::renderVoicesParallel(int numSamples) {
+    const int numActive = voiceAllocator.getNumActiveVoices();
+    const int numGroups = (numActive + voicesPerGroup - 1) / voicesPerGroup;
+    renderPool.run(&WavetableSynthesizer::renderVoiceGroup, this, numGroups, numSamples);
+
+    // Sum in group order so the result is the same however the work was shared out
+    for (int group = 0; group < numGroups; ++group) {
+        juce::FloatVectorOperations::add(mixBuffer.data(), renderPool.getGroupBuffer(group), numSamples);
     }
 }
 
+void WavetableSynthesizer::renderVoiceGroup(void* context, int groupIndex, float* output, int numSamples) {
+    auto& synth = *static_cast<WavetableSynthesizer*>(context);
+    const int first = groupIndex * voicesPerGroup;
+    const int last = std::min(first + voicesPerGroup, synth.voiceAllocator.getNumActiveVoices());
 
+    SynthVoice* group[voicesPerGroup];
+    for (int i = first; i < last; ++i) {
+        group[i - first] = &synth.voices[static_cast<size_t>(synth.renderOrder[static_cast<size_t>(i)])];
+    }
+    SynthVoice::renderGroup(group, last - first, output, numSamples);
+}
 
 void WavetableSynthesizer::handleNoteOn(int noteNumber, float velocity) {
-    for (auto& voice : voices) {
-        if (!voice->isActive()) {
-            voice->startNote(noteNumber, velocity);  // Use the simpler overload
-            break;
-        }
+    const int voiceIndex = voiceAllocator.startNote(noteNumber, [this](int index) {
+        return hotState.getEnvelopeLevel(index);
+    });
+
+    if (voiceIndex >= 0) {
+        voices[static_cast<size_t>(voiceIndex)].startNote(noteNumber, velocity);  // Restarts the voice if it was stolen
+        voices[static_cast<size_t>(voiceIndex)].alignControlUpdates(controlInterval - controlPosition);
     }
 }
 
 void WavetableSynthesizer::handleNoteOff(int noteNumber, float velocity) {
-    for (auto& voice : voices) {
-        if (voice->getNoteNumber() == noteNumber && voice->isActive()) {
-            voice->stopNote(true);  // `true` allows the note to tail off gracefully
+    voiceAllocator.releaseNote(noteNumber, [this](int index) {
+        voices[static_cast<size_t>(index)].stopNote(true);  // `true` allows the note to tail off gracefully
+    });
+}
+
+void WavetableSynthesizer::releaseFinishedVoices() {
+    // Walk backwards: voiceFinished swaps the last active entry into the freed slot
+    const int* activeVoices = voiceAllocator.getActiveVoices();
+    for (int i = voiceAllocator.getNumActiveVoices() - 1; i >= 0; --i) {
+        if (!voices[static_cast<size_t>(activeVoices[i])].isActive()) {
+            voiceAllocator.voiceFinished(activeVoices[i]);
         }
     }
 }
 
+void WavetableSynthesizer::setPolyphony(int numVoices) {
+    voiceAllocator.setPolyphony(numVoices);
+}
+
+void WavetableSynthesizer::setStealingPolicy(VoiceAllocator::StealingPolicy policy) {
+    voiceAllocator.setStealingPolicy(policy);
+}
+
 
 void WavetableSynthesizer::setUnisonSize(int size) {
     for (auto& voice : voices) {
-        voice->setUnisonSize(size);
+        voice.setUnisonSize(size);
     }
 }
 
 void WavetableSynthesizer::setDetuneAmount(float amount) {
     for (auto& voice : voices) {
-        voice->setDetuneAmount(amount);
+        voice.setDetuneAmount(amount);
+    }
+}
+
+void WavetableSynthesizer::setFilterControlInterval(int numSamples) {
+    controlInterval = juce::jlimit(1, 256, numSamples);
+    controlPosition = 0;
+    for (auto& voice : voices) {
+        voice.setFilterControlInterval(controlInterval);
+        voice.alignControlUpdates(controlInterval);
+    }
+}
+
+void WavetableSynthesizer::setFilterMode(SVFFilterBank::Mode mode) {
+    filterBank.setMode(mode);
+}
+
+void WavetableSynthesizer::setFilterParameters(float cutoff, float resonance) {
+    for (auto& voice : voices) {
+        voice.setFilterParameters(cutoff, resonance);
+    }
+}
+
+void WavetableSynthesizer::setLFOParameters(float rateHz, float depth) {
+    for (auto& voice : voices) {
+        voice.setLFORate(rateHz);
+    }
+    modulationMatrix.setRouting(lfoDepthRouting, ModulationMatrix::VoiceLFO, ModulationMatrix::Cutoff, depth);
+}
+
+void WavetableSynthesizer::setModulationRouting(int slot, ModulationMatrix::Source source,
+                                                ModulationMatrix::Destination destination, float amount) {
+    if (slot == lfoDepthRouting) {
+        jassertfalse;  // Reserved for setLFOParameters
+        return;
+    }
+    modulationMatrix.setRouting(slot, source, destination, amount);
+}
+
+void WavetableSynthesizer::setGlobalLFO(TableLFO::Shape shape, float rateHz) {
+    globalLFO.setShape(shape);
+    globalLFO.setRate(rateHz);
+}
+
+void WavetableSynthesizer::setEnvelopeParameters(const juce::ADSR::Parameters& parameters) {
+    for (auto& voice : voices) {
+        voice.updateADSR(parameters.attack, parameters.decay, parameters.sustain, parameters.release);
     }
 }
 
@@ -82,19 +226,38 @@ void WavetableSynthesizer::setVolume(float volume) {
 
 void WavetableSynthesizer::setWaveform(Waveform newWaveform) {
     currentWaveform = newWaveform;
-    fillWavetable();
+    for (auto& voice : voices) {
+        voice.setWaveform(currentWaveform);
+    }
+}
+
+WavetableBank* WavetableSynthesizer::swapWavetableBank(WavetableBank* newBank) {
+    jassert(newBank != nullptr);
+    auto* previousBank = activeBank;
+    activeBank = newBank;
+    for (auto& voice : voices) {
+        voice.setWavetable(activeBank);
+    }
+    return previousBank;
 }
 
-void WavetableSynthesizer::fillWavetable() {
-    wavetables[Sine].resize(tableSize);
-    wavetables[Square].resize(tableSize);
-    wavetables[Triangle].resize(tableSize);
-    wavetables[Sawtooth].resize(tableSize);
+WavetableBank::Ptr WavetableSynthesizer::getDefaultBank() {
+    static const WavetableBank::Ptr defaultBank = [] {
+        // Generate naive single cycles, then let the bank band-limit them into mip levels
+        WavetableBank::Ptr bank = new WavetableBank(NumWaveforms);
+        std::vector<float> singleCycle(tableSize);
 
-    generateSineWave(wavetables[Sine]);
-    generateSquareWave(wavetables[Square]);
-    generateTriangleWave(wavetables[Triangle]);
-    generateSawtoothWave(wavetables[Sawtooth]);
+        generateSineWave(singleCycle);
+        bank->setWaveform(Sine, singleCycle);
+        generateSquareWave(singleCycle);
+        bank->setWaveform(Square, singleCycle);
+        generateTriangleWave(singleCycle);
+        bank->setWaveform(Triangle, singleCycle);
+        generateSawtoothWave(singleCycle);
+        bank->setWaveform(Sawtooth, singleCycle);
+        return bank;
+    }();
+    return defaultBank;
 }
 
 void WavetableSynthesizer::generateSineWave(std::vector<float>& table) {
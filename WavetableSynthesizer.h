@@ -2,6 +2,15 @@
 
 #include <JuceHeader.h>
 #include "SynthVoice.h"
+#include "WavetableBank.h"
+#include "VoiceAllocator.h"
+#include "VoiceRenderPool.h"
+#include "SVFFilterBank.h"
+#include "VoiceHotState.h"
+#include "ModulationMatrix.h"
+#include "TableLFO.h"
+#include <array>
+#include <atomic>
 
 class WavetableSynthesizer {
 public:
@@ -14,27 +23,109 @@ public:
 
     void prepareToPlay(double sampleRate, int samplesPerBlock);
     void releaseResources();
-    void renderNextBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int startSample, int numSamples);
+    // Adds numSamples of the voices into buffer from startSample on. MIDI is
+    // dispatched separately through handleNoteOn/handleNoteOff between calls.
+    void renderNextBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
     void handleNoteOn(int noteNumber, float velocity);
     void setVolume(float volume);
     void setWaveform(Waveform newWaveform);
-    float getNextSample();
     void setUnisonSize(int size);
     void setDetuneAmount(float amount);
+    void setFilterControlInterval(int numSamples);
+    // Low-, band- or high-pass for every voice
+    void setFilterMode(SVFFilterBank::Mode mode);
+    // Audio thread, once per block: new targets for every voice. Cutoff and
+    // resonance are smoothed inside the voices; envelope changes apply to
+    // sounding notes straight away.
+    void setFilterParameters(float cutoff, float resonance);
+    // Per-voice LFO rate, and its swing of the cutoff in octaves through the
+    // matrix's reserved routing
+    void setLFOParameters(float rateHz, float depth);
+    void setEnvelopeParameters(const juce::ADSR::Parameters& parameters);
     void handleNoteOff(int noteNumber, float velocity);
-    
+
+    // Number of voices allowed to sound at once, up to maxVoices
+    void setPolyphony(int numVoices);
+    void setStealingPolicy(VoiceAllocator::StealingPolicy policy);
+    int getNumActiveVoices() const { return voiceAllocator.getNumActiveVoices(); }
+
+    static constexpr int maxVoices = 256;  // Size of the preallocated voice pool
+
+    // Number of extra threads used to render voices in parallel; 0 renders
+    // everything on the audio thread. Takes effect at the next prepareToPlay.
+    void setNumRenderThreads(int numThreads);
+
+    // Audio thread: points every voice at newBank, taking over one reference to
+    // it, and returns the bank it replaces with its reference for the caller to
+    // release off the audio thread
+    WavetableBank* swapWavetableBank(WavetableBank* newBank);
+
+    // Audio thread. Slots 1 to ModulationMatrix::maxRoutings - 1 are free;
+    // slot 0 carries the LFO depth from setLFOParameters.
+    void setModulationRouting(int slot, ModulationMatrix::Source source,
+                              ModulationMatrix::Destination destination, float amount);
+    // One LFO shared by every voice, so they all move together
+    void setGlobalLFO(TableLFO::Shape shape, float rateHz);
+
+    static constexpr int lfoDepthRouting = 0;
+
+    // Band-limited sine/square/triangle/saw bank, built once and shared by every
+    // synthesizer in the process
+    static WavetableBank::Ptr getDefaultBank();
+
 private:
     float masterVolume;
     double currentSampleRate;
-    std::vector<std::unique_ptr<SynthVoice>> voices;
-    std::array<std::vector<float>, NumWaveforms> wavetables;
+    // Hot per-sample state for every voice in contiguous arrays; the voice
+    // objects themselves hold what changes at note and control rate
+    VoiceHotState hotState { maxVoices };
+    std::vector<SynthVoice> voices;  // Contiguous, built once; never resized
+    VoiceAllocator voiceAllocator;
+    // The active voices in index order, refreshed for each chunk, so rendering
+    // walks the voice and state arrays forwards
+    std::array<int, maxVoices> renderOrder {};
+    std::vector<float> mixBuffer;  // Mono voice sum, sized in prepareToPlay
     Waveform currentWaveform;
 
-    void fillWavetable();
-    void generateSineWave(std::vector<float>& table);
-    void generateSquareWave(std::vector<float>& table);
-    void generateTriangleWave(std::vector<float>& table);
-    void generateSawtoothWave(std::vector<float>& table);
+    // One filter per voice, run several voices at a time in SIMD lanes
+    SVFFilterBank filterBank { maxVoices };
+    // All voices update their modulation on one grid, counted from here, so a
+    // group of voices renders in whole control intervals
+    int controlInterval = 32;
+    int controlPosition = 0;
+
+    // Read by the voices at control rate; the global LFO's value is updated once
+    // per rendered chunk
+    ModulationMatrix modulationMatrix;
+    TableLFO globalLFO;
+    float globalLFOValue = 0.0f;
+
+    // Holds one reference; replaced only by swapWavetableBank on the audio thread
+    WavetableBank* activeBank = nullptr;
+
+    void releaseFinishedVoices();
+    void updateRenderOrder();
+    void renderVoicesSerial(int numSamples);
+    void renderVoicesParallel(int numSamples);
+    static void renderVoiceGroup(void* context, int groupIndex, float* output, int numSamples);
+
+    VoiceRenderPool renderPool;
+    std::atomic<int> numRenderThreads { 0 };
+
+    // Voices are split into fixed groups by their position in renderOrder, so
+    // the summed result doesn't depend on thread count or scheduling. A group
+    // is one filter bank pass.
+    static constexpr int voicesPerGroup = SVFFilterBank::laneCount;
+    static constexpr int minVoicesForParallel = 8;  // Below this, threading costs more than it saves
+
+    // Per-voice gain; kept at the old 16-voice level so loudness doesn't depend on
+    // the pool size or polyphony setting
+    static constexpr float voiceHeadroom = 1.0f / 16.0f;
+
+    static void generateSineWave(std::vector<float>& table);
+    static void generateSquareWave(std::vector<float>& table);
+    static void generateTriangleWave(std::vector<float>& table);
+    static void generateSawtoothWave(std::vector<float>& table);
 
-    static constexpr int tableSize = 1024;  // Size of each waveform table
+    static constexpr int tableSize = WavetableBank::tableSize;  // Size of each single-cycle source table
 };